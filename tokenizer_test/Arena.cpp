@@ -0,0 +1,117 @@
+#include "arena.h"
+#include "lexer.h"
+#include <algorithm> // For std::max
+#include <cstdint>   // For uintptr_t
+#include <cstdlib>   // For malloc, free
+#include <cstring>   // For memcpy
+#include <new>       // For std::bad_alloc
+#include <vector>
+
+Arena::Arena(size_t blockSize) : blockSize_(std::max<size_t>(blockSize, 256)) {}
+
+Arena::~Arena() {
+    while (head_) {
+        Block* next = head_->next;
+        free(head_);
+        head_ = next;
+    }
+}
+
+// Start a new block big enough for minimum bytes (plus worst-case alignment)
+void Arena::grow(size_t minimum) {
+    size_t size = std::max(blockSize_, minimum + alignof(std::max_align_t));
+    Block* block = static_cast<Block*>(malloc(sizeof(Block) + size));
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    block->next = head_;
+    block->size = size;
+    head_ = block;
+    cursor_ = reinterpret_cast<char*>(block + 1);
+    limit_ = cursor_ + size;
+    capacity_ += size;
+
+    // Later blocks double so that large inputs need only a handful of them
+    blockSize_ = std::max(blockSize_, size) * 2;
+}
+
+void* Arena::allocate(size_t size, size_t align) {
+    uintptr_t address = (reinterpret_cast<uintptr_t>(cursor_) + (align - 1)) & ~static_cast<uintptr_t>(align - 1);
+    if (!cursor_ || address + size > reinterpret_cast<uintptr_t>(limit_)) {
+        grow(size + align);
+        address = (reinterpret_cast<uintptr_t>(cursor_) + (align - 1)) & ~static_cast<uintptr_t>(align - 1);
+    }
+    char* result = reinterpret_cast<char*>(address);
+    used_ += (result + size) - cursor_;
+    cursor_ = result + size;
+    return result;
+}
+
+std::string_view Arena::copy(std::string_view text) {
+    if (text.empty()) {
+        return std::string_view();
+    }
+    char* storage = static_cast<char*>(allocate(text.length(), 1));
+    memcpy(storage, text.data(), text.length());
+    return std::string_view(storage, text.length());
+}
+
+void Arena::reserve(size_t size) {
+    if (!cursor_ || static_cast<size_t>(limit_ - cursor_) < size + alignof(std::max_align_t)) {
+        grow(size);
+    }
+}
+
+// Keep only the newest block (the largest, since blocks double) and rewind it
+void Arena::reset() {
+    if (!head_) {
+        return;
+    }
+    Block* keep = head_;
+    Block* block = head_->next;
+    while (block) {
+        Block* next = block->next;
+        free(block);
+        block = next;
+    }
+    keep->next = nullptr;
+    head_ = keep;
+    cursor_ = reinterpret_cast<char*>(keep + 1);
+    limit_ = cursor_ + keep->size;
+    capacity_ = keep->size;
+    used_ = 0;
+}
+
+ArenaTokens tokenizeArena(std::string_view input, Arena& arena) {
+    // Spans are collected in a per-thread scratch vector that is reused across
+    // calls, so steady-state runs touch the heap only through the arena.
+    thread_local std::vector<TokenSpan> spans;
+    spans.clear();
+    Lexer lexer(input);
+    lexer.drain(spans);
+
+    // One block for the source copy and the token array
+    arena.reserve(input.length() + spans.size() * sizeof(ArenaToken) + alignof(ArenaToken));
+    std::string_view source = arena.copy(input);
+    ArenaToken* tokens = arena.allocateArray<ArenaToken>(spans.size());
+
+    for (size_t k = 0; k < spans.size(); k++) {
+        const TokenSpan& span = spans[k];
+        std::string_view text = source.substr(span.offset, span.length);
+        std::string_view value = text;
+        if (span.type == TOK_STRING || span.type == TOK_CHAR) {
+            // Literals without escapes are viewed in place; others are decoded into the arena
+            std::string_view body = literalBody(text);
+            if (body.find('\\') == std::string_view::npos) {
+                value = body;
+            }
+            else {
+                char* decoded = static_cast<char*>(arena.allocate(body.length(), 1));
+                value = std::string_view(decoded, unescapeLiteral(text, decoded));
+            }
+        }
+        tokens[k] = ArenaToken{ span.type, span.offset, text, value };
+    }
+
+    return ArenaTokens{ tokens, spans.size() };
+}
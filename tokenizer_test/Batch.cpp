@@ -0,0 +1,129 @@
+#include "batch.h"
+#include <algorithm>    // For std::stable_sort, std::min
+#include <cstdint>      // For uintmax_t
+#include <chrono>
+#include <deque>
+#include <filesystem>   // For file sizes used in balancing
+#include <mutex>
+#include <numeric>      // For std::iota
+#include <system_error>
+#include <thread>
+
+// One worker's queue of file indices. Padded to a cache line so that workers
+// polling their own queues do not false-share with their neighbours.
+struct alignas(64) WorkQueue {
+    std::mutex lock;
+    std::deque<size_t> files;  // Largest file at the front
+};
+
+// Take work from the front of our own queue (largest first)
+static bool popOwn(WorkQueue& queue, size_t& file) {
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.files.empty()) {
+        return false;
+    }
+    file = queue.files.front();
+    queue.files.pop_front();
+    return true;
+}
+
+// Take work from the back of a peer's queue (smallest first), so the owner keeps its big files
+static bool steal(WorkQueue& queue, size_t& file) {
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.files.empty()) {
+        return false;
+    }
+    file = queue.files.back();
+    queue.files.pop_back();
+    return true;
+}
+
+// Map and lex one file into its result slot
+static void processFile(FileResult& result, unsigned worker, WorkerStats& stats) {
+    auto begin = std::chrono::steady_clock::now();
+    try {
+        result.file = tokenizeFile(result.path);
+        stats.bytes += result.file.file.size();
+        stats.tokens += result.file.tokens.size();
+    }
+    catch (const std::exception& error) {
+        result.error = error.what();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    result.seconds = std::chrono::duration<double>(end - begin).count();
+    result.worker = worker;
+    stats.files++;
+    stats.busySeconds += result.seconds;
+}
+
+BatchResult tokenizeBatch(const std::vector<std::string>& paths, unsigned threads) {
+    auto begin = std::chrono::steady_clock::now();
+
+    BatchResult batch;
+    batch.files.resize(paths.size());
+    for (size_t k = 0; k < paths.size(); k++) {
+        batch.files[k].path = paths[k];
+    }
+
+    unsigned workerCount = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    workerCount = static_cast<unsigned>(std::min<size_t>(workerCount, std::max<size_t>(paths.size(), 1)));
+    batch.workers.resize(workerCount);
+
+    // Largest files first, dealt round-robin (unreadable files sort last and fail fast)
+    std::vector<uintmax_t> sizes(paths.size());
+    for (size_t k = 0; k < paths.size(); k++) {
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(paths[k], ec);
+        sizes[k] = ec ? 0 : size;
+    }
+    std::vector<size_t> order(paths.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    std::vector<WorkQueue> queues(workerCount);
+    for (size_t k = 0; k < order.size(); k++) {
+        queues[k % workerCount].files.push_back(order[k]);
+    }
+
+    // Statistics accumulate in a worker-local struct and are published once at the end
+    auto work = [&](unsigned self) {
+        WorkerStats stats;
+        size_t file;
+        for (;;) {
+            if (popOwn(queues[self], file)) {
+                processFile(batch.files[file], self, stats);
+                continue;
+            }
+            // Own queue is dry: try every peer once, starting with the next one
+            bool stole = false;
+            for (unsigned step = 1; step < workerCount && !stole; step++) {
+                stole = steal(queues[(self + step) % workerCount], file);
+            }
+            if (!stole) {
+                batch.workers[self] = stats;
+                return;  // No queue refills, so all work is taken
+            }
+            stats.steals++;
+            processFile(batch.files[file], self, stats);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workerCount - 1);
+    for (unsigned w = 1; w < workerCount; w++) {
+        pool.emplace_back(work, w);
+    }
+    work(0);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    for (const FileResult& result : batch.files) {
+        if (!result.error.empty()) {
+            batch.failed++;
+        }
+    }
+    batch.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return batch;
+}
@@ -0,0 +1,131 @@
+#include "dependencyscan.h"
+#include "directive.h"
+#include "lexer.h"
+#include "scan.h"
+#include <algorithm>  // For std::min, std::max
+#include <atomic>
+#include <thread>
+
+// Trailing blanks (and a \r before the newline) are not part of a condition
+static std::string_view trimRight(std::string_view text) {
+    size_t end = text.length();
+    while (end > 0 && (text[end - 1] == ' ' || text[end - 1] == '\t' || text[end - 1] == '\r')) {
+        end--;
+    }
+    return text.substr(0, end);
+}
+
+// Bytes that may precede a digit separator inside a number
+static bool isNumberByte(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '.';
+}
+
+void scanDependencies(std::string_view source, std::vector<Dependency>& out) {
+    const char* data = source.data();
+    const char* end = data + source.length();
+    uint32_t depth = 0;
+    size_t i = 0;
+
+    for (;;) {
+        // Nothing but these four bytes can start a comment, literal or directive
+        const char* stop = findDirectiveOrLiteral(data + i, end);
+        if (stop == end) {
+            break;
+        }
+        size_t at = stop - data;
+        size_t start = at;
+        if (*stop == '\'') {
+            // A quote may be a digit separator (1'000, 1e+'5): lex from the start of the word before it
+            while (start > i) {
+                char c = data[start - 1];
+                if (isNumberByte(c)) {
+                    start--;
+                }
+                else if ((c == '+' || c == '-') && start - 1 > i &&
+                    ((data[start - 2] | 0x20) == 'e' || (data[start - 2] | 0x20) == 'p')) {
+                    start -= 2;
+                }
+                else {
+                    break;
+                }
+            }
+        }
+        Lexer lexer(source, start);
+        TokenSpan token = lexer.next();
+        while (size_t(token.offset) + token.length <= at && token.type != TOK_EOF) {
+            token = lexer.next();
+        }
+        i = size_t(token.offset) + token.length;
+        if (!isDirective(token.type)) {
+            continue;  // Comment, literal or a '/' operator
+        }
+
+        Dependency dependency{ token.type, token.offset, token.length, depth, false, std::string_view() };
+        std::string_view text = token.text(source);
+        switch (token.type) {
+        case TOK_PP_INCLUDE:
+            includePath(text, dependency.text, dependency.angled);
+            break;
+        case TOK_PP_IF:
+        case TOK_PP_IFDEF:
+        case TOK_PP_IFNDEF:
+            dependency.text = trimRight(directiveBody(text));
+            depth++;
+            break;
+        case TOK_PP_ELIF:
+            dependency.depth = depth > 0 ? depth - 1 : 0;
+            dependency.text = trimRight(directiveBody(text));
+            break;
+        case TOK_PP_ELSE:
+            dependency.depth = depth > 0 ? depth - 1 : 0;
+            break;
+        case TOK_PP_ENDIF:
+            // An unbalanced #endif leaves the depth at 0
+            depth = depth > 0 ? depth - 1 : 0;
+            dependency.depth = depth;
+            break;
+        default:
+            continue;  // #define, #pragma, ...
+        }
+        out.push_back(dependency);
+    }
+}
+
+// Map and scan one file into its result slot
+static void scanFile(FileDependencies& result) {
+    try {
+        result.file = MappedFile(result.path);
+        scanDependencies(result.file.view(), result.dependencies);
+    }
+    catch (const std::exception& error) {
+        result.error = error.what();
+    }
+}
+
+std::vector<FileDependencies> scanDependencyFiles(const std::vector<std::string>& paths, unsigned threads) {
+    std::vector<FileDependencies> results(paths.size());
+    for (size_t k = 0; k < paths.size(); k++) {
+        results[k].path = paths[k];
+    }
+
+    // Scanning is fast enough that files are taken one at a time from a shared counter
+    unsigned workerCount = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    workerCount = static_cast<unsigned>(std::min<size_t>(workerCount, std::max<size_t>(paths.size(), 1)));
+    std::atomic<size_t> nextFile{ 0 };
+    auto work = [&]() {
+        for (size_t k = nextFile++; k < results.size(); k = nextFile++) {
+            scanFile(results[k]);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workerCount - 1);
+    for (unsigned w = 1; w < workerCount; w++) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    return results;
+}
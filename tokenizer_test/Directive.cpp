@@ -0,0 +1,138 @@
+#include "directive.h"
+#include "lexer.h"
+#include <cstring> // For memcmp
+
+// Directive spellings and the TokenType each lexes as
+struct DirectiveSpec {
+    const char* name;
+    TokenType type;
+};
+
+static const DirectiveSpec directiveSpecs[] = {
+    { "if", TOK_PP_IF }, { "elif", TOK_PP_ELIF }, { "else", TOK_PP_ELSE }, { "line", TOK_PP_LINE },
+    { "endif", TOK_PP_ENDIF }, { "error", TOK_PP_ERROR }, { "ifdef", TOK_PP_IFDEF }, { "undef", TOK_PP_UNDEF },
+    { "define", TOK_PP_DEFINE }, { "ifndef", TOK_PP_IFNDEF }, { "import", TOK_PP_INCLUDE }, { "pragma", TOK_PP_PRAGMA },
+    { "elifdef", TOK_PP_ELIF }, { "include", TOK_PP_INCLUDE }, { "warning", TOK_PP_WARNING },
+    { "elifndef", TOK_PP_ELIF }, { "include_next", TOK_PP_INCLUDE },
+};
+
+// Linear scan; directives are rare next to ordinary tokens and the names are short
+TokenType directiveType(std::string_view name) {
+    for (const DirectiveSpec& spec : directiveSpecs) {
+        if (name.length() == strlen(spec.name) && memcmp(name.data(), spec.name, name.length()) == 0) {
+            return spec.type;
+        }
+    }
+    return TOK_HEADER;
+}
+
+// Length of a backslash-newline continuation at i (0 if there is none)
+static size_t continuationAt(std::string_view text, size_t i) {
+    if (i < text.length() && text[i] == '\\') {
+        if (i + 1 < text.length() && text[i + 1] == '\n') {
+            return 2;
+        }
+        if (i + 2 < text.length() && text[i + 1] == '\r' && text[i + 2] == '\n') {
+            return 3;
+        }
+    }
+    return 0;
+}
+
+// Skip blanks, block comments and continuations inside a directive line
+static size_t skipDirectiveSpace(std::string_view text, size_t i) {
+    while (i < text.length()) {
+        char c = text[i];
+        if (c == ' ' || c == '\t' || c == '\v' || c == '\f' || c == '\r') {
+            i++;
+        }
+        else if (size_t skip = continuationAt(text, i)) {
+            i += skip;
+        }
+        else if (c == '/' && i + 1 < text.length() && text[i + 1] == '*') {
+            size_t close = text.find("*/", i + 2);
+            i = close == std::string_view::npos ? text.length() : close + 2;
+        }
+        else {
+            break;
+        }
+    }
+    return i;
+}
+
+static bool isIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+std::string_view directiveName(std::string_view directive) {
+    size_t start = skipDirectiveSpace(directive, 1);
+    size_t end = start;
+    while (end < directive.length() && isIdentifierChar(directive[end])) {
+        end++;
+    }
+    return directive.substr(start, end - start);
+}
+
+std::string_view directiveBody(std::string_view directive) {
+    std::string_view name = directiveName(directive);
+    size_t afterName = name.data() - directive.data() + name.length();
+    return directive.substr(skipDirectiveSpace(directive, afterName));
+}
+
+bool includePath(std::string_view directive, std::string_view& path, bool& angled) {
+    std::string_view body = directiveBody(directive);
+    if (body.empty() || (body[0] != '<' && body[0] != '"')) {
+        return false;
+    }
+    angled = body[0] == '<';
+    size_t close = body.find(angled ? '>' : '"', 1);
+    if (close == std::string_view::npos) {
+        return false;
+    }
+    path = body.substr(1, close - 1);
+    return true;
+}
+
+void lexDirective(std::string_view source, const TokenSpan& directive, std::vector<TokenSpan>& out) {
+    std::string_view text = directive.text(source);
+    size_t end = size_t(directive.offset) + directive.length;
+    auto span = [](TokenType type, size_t offset, size_t length) {
+        return TokenSpan{ type, static_cast<uint32_t>(offset), static_cast<uint32_t>(length) };
+    };
+
+    out.push_back(span(TOK_PUNCTUATION, directive.offset, 1));
+    size_t position = size_t(directive.offset) + 1;
+
+    std::string_view name = directiveName(text);
+    if (!name.empty()) {
+        position = name.data() - source.data();
+        out.push_back(span(TOK_IDENTIFIER, position, name.length()));
+        position += name.length();
+    }
+
+    // A header name is a single token; lexed normally, <a/b.h> would be operators
+    std::string_view path;
+    bool angled;
+    if (directive.type == TOK_PP_INCLUDE && includePath(text, path, angled)) {
+        size_t open = path.data() - source.data() - 1;
+        out.push_back(span(TOK_STRING, open, path.length() + 2));
+        position = open + path.length() + 2;
+    }
+
+    // Lex the rest inside a window ending with the directive, so nothing runs past it
+    std::string_view window = source.substr(0, end);
+    Lexer lexer(window, position);
+    for (TokenSpan token = lexer.next(); token.type != TOK_EOF; token = lexer.next()) {
+        if (source[token.offset] == '#') {
+            // Stringizing or token pasting, not a nested directive
+            size_t length = (token.offset + 1 < end && source[token.offset + 1] == '#') ? 2 : 1;
+            out.push_back(span(TOK_OPERATOR, token.offset, length));
+            lexer = Lexer(window, token.offset + length);
+            continue;
+        }
+        if (token.type == TOK_PUNCTUATION && continuationAt(window, token.offset)) {
+            continue;
+        }
+        out.push_back(token);
+    }
+}
@@ -0,0 +1,116 @@
+#include "incrementallexer.h"
+#include "lexer.h"
+#include "streamlexer.h" // For StreamLexer::lookahead
+#include <algorithm>     // For std::max
+#include <cstdint>
+#include <stdexcept>     // For std::out_of_range
+
+IncrementalLexer::IncrementalLexer(std::string_view source) : length_(source.length()) {
+    tokenize(source, tokens_);
+    gapBegin_ = gapEnd_ = tokens_.size();
+}
+
+IncrementalLexer::IncrementalLexer(std::vector<TokenSpan> tokens, size_t sourceLength)
+    : tokens_(std::move(tokens)), length_(sourceLength) {
+    gapBegin_ = gapEnd_ = tokens_.size();
+}
+
+// Move the gap so that it starts at token index; tokens crossing it switch
+// between absolute and end-relative offsets
+void IncrementalLexer::moveGap(size_t index) {
+    while (gapBegin_ > index) {
+        TokenSpan token = tokens_[--gapBegin_];
+        token.offset = static_cast<uint32_t>(length_ - token.offset);
+        tokens_[--gapEnd_] = token;
+    }
+    while (gapBegin_ < index) {
+        TokenSpan token = tokens_[gapEnd_++];
+        token.offset = static_cast<uint32_t>(length_ - token.offset);
+        tokens_[gapBegin_++] = token;
+    }
+}
+
+// Make room for at least count tokens in the gap
+void IncrementalLexer::reserveGap(size_t count) {
+    if (gapEnd_ - gapBegin_ >= count) {
+        return;
+    }
+    size_t tail = tokens_.size() - gapEnd_;
+    size_t gap = std::max(count, size() / 8 + 64);
+
+    std::vector<TokenSpan> grown(gapBegin_ + gap + tail);
+    std::copy(tokens_.begin(), tokens_.begin() + gapBegin_, grown.begin());
+    std::copy(tokens_.begin() + gapEnd_, tokens_.end(), grown.begin() + gapBegin_ + gap);
+    tokens_.swap(grown);
+    gapEnd_ = gapBegin_ + gap;
+}
+
+RelexResult IncrementalLexer::edit(std::string_view source, const TextEdit& change) {
+    if (change.offset > length_ || change.removed > length_ - change.offset ||
+        source.length() != length_ - change.removed + change.inserted) {
+        throw std::out_of_range("IncrementalLexer: edit does not match the source");
+    }
+
+    // Tokens ending more than the lexer's lookahead before the edit cannot
+    // have seen it; everything from the first other token on is re-lexed
+    size_t low = 0;
+    size_t high = size();
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        TokenSpan token = (*this)[mid];
+        if (size_t(token.offset) + token.length + StreamLexer::lookahead < change.offset) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    size_t first = low;
+    size_t restart = 0;
+    if (first > 0) {
+        TokenSpan previous = (*this)[first - 1];
+        restart = previous.offset + previous.length;
+    }
+
+    // With the gap at first, every old token from first on is end-relative,
+    // so the ones after the edit already have their new offsets
+    moveGap(first);
+    length_ = source.length();
+    int64_t newLength = static_cast<int64_t>(length_);
+    size_t editEnd = change.offset + change.inserted;
+
+    RelexResult result{ first, 0, 0 };
+    Lexer lexer(source, restart);
+    for (;;) {
+        TokenSpan token = lexer.next();
+
+        // Drop old tokens the new ones have moved past (offsets of old tokens
+        // before the end of the edit are meaningless, but still increasing)
+        while (gapEnd_ < tokens_.size() && newLength - tokens_[gapEnd_].offset < int64_t(token.offset)) {
+            gapEnd_++;
+            result.removed++;
+        }
+        if (token.type == TOK_EOF) {
+            result.removed += tokens_.size() - gapEnd_;
+            gapEnd_ = tokens_.size();
+            break;
+        }
+        // Resynchronized: an old token starts here, in text the edit did not touch
+        if (token.offset >= editEnd && gapEnd_ < tokens_.size() &&
+            newLength - tokens_[gapEnd_].offset == int64_t(token.offset)) {
+            break;
+        }
+
+        reserveGap(1);
+        tokens_[gapBegin_++] = token;
+        result.inserted++;
+    }
+    return result;
+}
+
+void IncrementalLexer::copyTo(std::vector<TokenSpan>& out) const {
+    out.resize(size());
+    for (size_t i = 0; i < out.size(); i++) {
+        out[i] = (*this)[i];
+    }
+}
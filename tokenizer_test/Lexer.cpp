@@ -0,0 +1,482 @@
+#include "lexer.h"
+#include "directive.h"
+#include "scan.h"
+#include <algorithm> // For std::min
+#include <array>     // For the character class table
+#include <stdexcept> // For std::length_error
+
+// Character classes for the lexer dispatch. CC_IDENT and CC_DIGIT come first
+// so "continues an identifier" is a single compare (cls <= CC_DIGIT).
+enum CharClass : uint8_t {
+    CC_IDENT = 0,      // A-Z, a-z, _
+    CC_DIGIT = 1,      // 0-9
+    CC_SPACE = 2,      // ' ', \t, \n, \v, \f, \r
+    CC_HASH = 3,       // # starts a preprocessor directive
+    CC_SLASH = 4,      // / starts a comment or an operator
+    CC_COLON = 5,      // : starts :: or punctuation
+    CC_OPERATOR = 6,   // Remaining operator characters
+    CC_PUNCT = 7,      // Remaining punctuation
+    CC_DQUOTE = 8,     // " starts a string literal
+    CC_SQUOTE = 9,     // ' starts a character literal
+    CC_OTHER = 10,     // Control characters and bytes >= 0x80
+    CC_DOT = 11,       // . starts a number before a digit, punctuation otherwise
+};
+
+// Build the 256-entry class table at compile time (C locale semantics)
+static constexpr std::array<uint8_t, 256> buildCharClassTable() {
+    std::array<uint8_t, 256> table{};
+    for (int c = 0; c < 256; c++) {
+        table[c] = CC_OTHER;
+    }
+    for (int c = 'a'; c <= 'z'; c++) {
+        table[c] = CC_IDENT;
+    }
+    for (int c = 'A'; c <= 'Z'; c++) {
+        table[c] = CC_IDENT;
+    }
+    table['_'] = CC_IDENT;
+    for (int c = '0'; c <= '9'; c++) {
+        table[c] = CC_DIGIT;
+    }
+    for (char c : { ' ', '\t', '\n', '\v', '\f', '\r' }) {
+        table[static_cast<unsigned char>(c)] = CC_SPACE;
+    }
+    for (char c : { '$', '(', ')', ',', ';', '?', '@', '[', '\\', ']', '`', '{', '}' }) {
+        table[static_cast<unsigned char>(c)] = CC_PUNCT;
+    }
+    for (char c : { '+', '-', '*', '=', '<', '>', '!', '&', '|', '^', '%', '~' }) {
+        table[static_cast<unsigned char>(c)] = CC_OPERATOR;
+    }
+    table['#'] = CC_HASH;
+    table['.'] = CC_DOT;
+    table['/'] = CC_SLASH;
+    table[':'] = CC_COLON;
+    table['"'] = CC_DQUOTE;
+    table['\''] = CC_SQUOTE;
+    return table;
+}
+
+static constexpr std::array<uint8_t, 256> charClassTable = buildCharClassTable();
+
+static inline uint8_t charClass(char c) {
+    return charClassTable[static_cast<unsigned char>(c)];
+}
+
+// Operator and punctuator spellings with the type each lexes as. Digraphs
+// (<: %> ...) are left out: "<::" would need the standard's special case.
+struct OperatorSpec {
+    const char* text;
+    TokenType type;
+};
+
+static constexpr OperatorSpec operatorSpecs[] = {
+    { "+", TOK_OPERATOR }, { "-", TOK_OPERATOR }, { "*", TOK_OPERATOR }, { "/", TOK_OPERATOR },
+    { "%", TOK_OPERATOR }, { "^", TOK_OPERATOR }, { "&", TOK_OPERATOR }, { "|", TOK_OPERATOR },
+    { "~", TOK_OPERATOR }, { "!", TOK_OPERATOR }, { "=", TOK_OPERATOR }, { "<", TOK_OPERATOR },
+    { ">", TOK_OPERATOR },
+    { "+=", TOK_OPERATOR }, { "-=", TOK_OPERATOR }, { "*=", TOK_OPERATOR }, { "/=", TOK_OPERATOR },
+    { "%=", TOK_OPERATOR }, { "^=", TOK_OPERATOR }, { "&=", TOK_OPERATOR }, { "|=", TOK_OPERATOR },
+    { "==", TOK_OPERATOR }, { "!=", TOK_OPERATOR }, { "<=", TOK_OPERATOR }, { ">=", TOK_OPERATOR },
+    { "&&", TOK_OPERATOR }, { "||", TOK_OPERATOR }, { "<<", TOK_OPERATOR }, { ">>", TOK_OPERATOR },
+    { "++", TOK_OPERATOR }, { "--", TOK_OPERATOR }, { ".*", TOK_OPERATOR },
+    { "<=>", TOK_OPERATOR }, { "<<=", TOK_OPERATOR }, { ">>=", TOK_OPERATOR }, { "->*", TOK_OPERATOR },
+    { "(", TOK_PUNCTUATION }, { ")", TOK_PUNCTUATION }, { "[", TOK_PUNCTUATION }, { "]", TOK_PUNCTUATION },
+    { "{", TOK_PUNCTUATION }, { "}", TOK_PUNCTUATION }, { ";", TOK_PUNCTUATION }, { ",", TOK_PUNCTUATION },
+    { ":", TOK_PUNCTUATION }, { "?", TOK_PUNCTUATION }, { ".", TOK_PUNCTUATION }, { "->", TOK_PUNCTUATION },
+    { "...", TOK_PUNCTUATION },
+    { "$", TOK_PUNCTUATION }, { "@", TOK_PUNCTUATION }, { "`", TOK_PUNCTUATION }, { "\\", TOK_PUNCTUATION },
+    { "::", TOK_SCOPE },
+};
+
+static constexpr size_t OPERATOR_SYMBOLS = 32;   // Distinct bytes the spellings may use
+static constexpr size_t OPERATOR_STATES = 64;    // Trie nodes, the root included
+static constexpr uint8_t NO_TRANSITION = 0;      // The root is never a transition target
+static constexpr uint8_t NOT_ACCEPTING = 0xFF;   // Prefix of longer spellings only ("..")
+
+// Maximal-munch DFA over the spellings above: a trie whose nodes record the
+// type of the spelling ending there. Built at compile time; a spelling set
+// that does not fit the table sizes fails the build.
+struct OperatorTable {
+    std::array<uint8_t, 256> symbol{};  // Column in next for each byte; OPERATOR_SYMBOLS if unused
+    std::array<std::array<uint8_t, OPERATOR_SYMBOLS>, OPERATOR_STATES> next{};
+    std::array<uint8_t, OPERATOR_STATES> accept{};
+    std::array<uint8_t, 256> single{};  // Type of bytes that are a whole token on their own: ( ) ; , ...
+};
+
+static constexpr OperatorTable buildOperatorTable() {
+    OperatorTable table{};
+    for (size_t c = 0; c < 256; c++) {
+        table.symbol[c] = OPERATOR_SYMBOLS;
+    }
+    for (size_t s = 0; s < OPERATOR_STATES; s++) {
+        table.accept[s] = NOT_ACCEPTING;
+    }
+
+    size_t symbols = 0;
+    size_t states = 1;
+    for (const OperatorSpec& spec : operatorSpecs) {
+        size_t state = 0;
+        for (const char* p = spec.text; *p; p++) {
+            unsigned char c = static_cast<unsigned char>(*p);
+            if (table.symbol[c] == OPERATOR_SYMBOLS) {
+                if (symbols == OPERATOR_SYMBOLS) {
+                    throw "OPERATOR_SYMBOLS is too small";
+                }
+                table.symbol[c] = static_cast<uint8_t>(symbols++);
+            }
+            uint8_t& target = table.next[state][table.symbol[c]];
+            if (target == NO_TRANSITION) {
+                if (states == OPERATOR_STATES) {
+                    throw "OPERATOR_STATES is too small";
+                }
+                target = static_cast<uint8_t>(states++);
+            }
+            state = target;
+        }
+        table.accept[state] = static_cast<uint8_t>(spec.type);
+    }
+
+    // A byte whose root transition leads to a state with no way out is its own token
+    for (size_t c = 0; c < 256; c++) {
+        table.single[c] = NOT_ACCEPTING;
+        if (table.symbol[c] == OPERATOR_SYMBOLS) {
+            continue;
+        }
+        size_t state = table.next[0][table.symbol[c]];
+        bool leaf = true;
+        for (size_t symbol = 0; symbol < OPERATOR_SYMBOLS; symbol++) {
+            leaf = leaf && table.next[state][symbol] == NO_TRANSITION;
+        }
+        if (leaf) {
+            table.single[c] = table.accept[state];
+        }
+    }
+    return table;
+}
+
+static constexpr OperatorTable operatorTable = buildOperatorTable();
+
+// Match the longest operator or punctuator at data[i]; returns its end, or i
+// if none starts there. Every transition is one table load, and the last
+// accepting state is remembered so that ".." backs off to ".". Single
+// characters with no longer spelling return without looking further.
+static inline size_t munchOperator(const char* data, size_t i, size_t length, TokenType& type) {
+    size_t end = i;
+    size_t state = 0;
+    uint8_t single = operatorTable.single[static_cast<unsigned char>(data[i])];
+    if (single != NOT_ACCEPTING) {
+        type = static_cast<TokenType>(single);
+        return i + 1;
+    }
+    while (i < length) {
+        uint8_t symbol = operatorTable.symbol[static_cast<unsigned char>(data[i])];
+        if (symbol == OPERATOR_SYMBOLS) {
+            break;
+        }
+        state = operatorTable.next[state][symbol];
+        if (state == NO_TRANSITION) {
+            break;
+        }
+        i++;
+        if (operatorTable.accept[state] != NOT_ACCEPTING) {
+            type = static_cast<TokenType>(operatorTable.accept[state]);
+            end = i;
+        }
+    }
+    return end;
+}
+
+size_t matchOperator(std::string_view source, size_t i, TokenType& type) {
+    return i < source.length() ? munchOperator(source.data(), i, source.length(), type) - i : 0;
+}
+
+bool operatorCanExtend(std::string_view text) {
+    size_t state = 0;
+    for (char c : text) {
+        uint8_t symbol = operatorTable.symbol[static_cast<unsigned char>(c)];
+        if (symbol == OPERATOR_SYMBOLS) {
+            return false;
+        }
+        state = operatorTable.next[state][symbol];
+        if (state == NO_TRANSITION) {
+            return false;
+        }
+    }
+    for (size_t symbol = 0; symbol < OPERATOR_SYMBOLS; symbol++) {
+        if (operatorTable.next[state][symbol] != NO_TRANSITION) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// End of a number starting at i (a digit, or a '.' before one). Like the
+// standard's pp-number this takes digits, letters, '_' and '.', a digit
+// separator when a digit or letter follows it, and the sign of an e/E/p/P
+// exponent, so "0x1Fu", "1'000'000", "6.02e+23f" and "10_km" are one token
+// each. Whether the text is a valid literal is up to parseNumber.
+static inline size_t numberEnd(const char* data, size_t i, size_t length) {
+    i++;
+    while (i < length) {
+        char c = data[i];
+        if (charClass(c) <= CC_DIGIT || c == '.') {
+            i++;
+        }
+        else if ((c == '+' || c == '-') && ((data[i - 1] | 0x20) == 'e' || (data[i - 1] | 0x20) == 'p')) {
+            i++;
+        }
+        else if (c == '\'' && i + 1 < length && charClass(data[i + 1]) <= CC_DIGIT) {
+            i += 2;
+        }
+        else {
+            break;
+        }
+    }
+    return i;
+}
+
+// End of a directive starting at the '#' at i: the first newline that is
+// neither escaped by a trailing backslash nor inside a block comment. Quotes
+// are skipped so that a "/*" inside a literal opens nothing, but a literal
+// never runs past its own line, so "#error don't" still ends where it should.
+static size_t directiveEnd(const char* data, size_t i, size_t length) {
+    const char* end = data + length;
+    i++;
+    while (i < length) {
+        char c = data[i];
+        if (c == '\n') {
+            size_t last = (i > 0 && data[i - 1] == '\r') ? i - 1 : i;
+            if (last > 0 && data[last - 1] == '\\') {
+                i++;
+                continue;  // Line continuation
+            }
+            return i;
+        }
+        if (c == '/' && i + 1 < length && data[i + 1] == '*') {
+            const char* close = findCommentEnd(data + i + 2, end);
+            if (close == end) {
+                return length;
+            }
+            i = close - data + 2;
+        }
+        else if (c == '/' && i + 1 < length && data[i + 1] == '/') {
+            // A line comment ends the directive with its (possibly continued) line
+            i = findLineEnd(data + i + 2, end) - data;
+        }
+        else if (c == '"' || c == '\'') {
+            i++;
+            while (i < length && data[i] != c && data[i] != '\n') {
+                if (data[i] == '\\' && i + 1 < length) {
+                    i += (data[i + 1] == '\r' && i + 2 < length && data[i + 2] == '\n') ? 3 : 2;
+                }
+                else {
+                    i++;
+                }
+            }
+            if (i < length && data[i] == c) {
+                i++;
+            }
+        }
+        else {
+            i++;
+        }
+    }
+    return length;
+}
+
+// Lex one token starting at the cursor. Each lexeme start costs one
+// class-table lookup and one switch dispatch, and runs inside a lexeme are
+// consumed by the vectorized kernels in scan.h. Under an instrumented
+// policy every lexeme also costs one timestamp read; otherwise the counting
+// below compiles to nothing.
+template <typename Policy>
+TokenSpan BasicLexer<Policy>::lex() {
+    const char* data = source_.data();
+    const char* end = data + source_.length();
+    size_t length = source_.length();
+    size_t i = cursor_;
+
+    // Each lexeme is timed from the end of the previous one (or entry) to its own end
+    [[maybe_unused]] uint64_t began = 0;
+    if constexpr (Policy::collectStats) {
+        began = readTimestamp();
+    }
+
+    // Count a lexeme covering source[start, i) against its dispatch branch
+    auto record = [&]([[maybe_unused]] LexBranch branch, [[maybe_unused]] size_t start) {
+        if constexpr (Policy::collectStats) {
+            uint64_t now = readTimestamp();
+            stats_.branchHits[branch]++;
+            stats_.branchBytes[branch] += i - start;
+            stats_.branchTicks[branch] += now - began;
+            began = now;
+        }
+    };
+
+    // Finish a token covering source[start, i) and park the cursor after it
+    auto emit = [&](TokenType type, size_t start, LexBranch branch) {
+        record(branch, start);
+        if constexpr (Policy::collectStats) {
+            stats_.tokens[type]++;
+            stats_.bytes[type] += i - start;
+        }
+        cursor_ = i;
+        return TokenSpan{ type, static_cast<uint32_t>(start), static_cast<uint32_t>(i - start) };
+    };
+
+    while (i < length) {
+        char current = data[i];
+        size_t start = i;
+
+        switch (charClass(current)) {
+        case CC_SPACE:
+            // Skip whitespace; single separators are handled without a kernel call
+            i++;
+            if (i < length && charClass(data[i]) == CC_SPACE) {
+                i = skipWhitespace(data + i + 1, end) - data;
+            }
+            record(LEX_WHITESPACE, start);
+            break;
+
+        case CC_HASH:
+            // Preprocessor directive: the whole logical line, typed by its name
+            i = directiveEnd(data, i, length);
+            if constexpr (Policy::keepDirectives) {
+                return emit(directiveType(directiveName(source_.substr(start, i - start))), start, LEX_DIRECTIVE);
+            }
+            record(LEX_DIRECTIVE, start);
+            break;
+
+        case CC_IDENT:
+            // Keywords and identifiers; most are short, so the kernel only takes over long names
+            i++;
+            while (i < length && charClass(data[i]) <= CC_DIGIT) {
+                if (i - start == 8) {
+                    i = skipIdentifier(data + i, end) - data;
+                    break;
+                }
+                i++;
+            }
+            {
+                TokenType type = classifyWord(source_.substr(start, i - start));
+                return emit(type, start, type == TOK_IDENTIFIER ? LEX_IDENTIFIER : LEX_KEYWORD);
+            }
+
+        case CC_DIGIT:
+            // Numeric literals of every base, with separators and suffixes
+            i = numberEnd(data, i, length);
+            return emit(TOK_NUMBER, start, LEX_NUMBER);
+
+        case CC_DOT:
+            // ".5" is a number; otherwise ".", ".*" or "..."
+            if (i + 1 < length && charClass(data[i + 1]) == CC_DIGIT) {
+                i = numberEnd(data, i, length);
+                return emit(TOK_NUMBER, start, LEX_NUMBER);
+            }
+            else {
+                TokenType type = TOK_PUNCTUATION;
+                i = munchOperator(data, i, length, type);
+                return emit(type, start, LEX_OPERATOR);
+            }
+
+        case CC_SLASH:
+            if (i + 1 < length && data[i + 1] == '/') {
+                // Single-line comment
+                i = findLineEnd(data + i + 2, end) - data;
+                if constexpr (Policy::keepComments) {
+                    return emit(TOK_COMMENT, start, LEX_COMMENT);
+                }
+                record(LEX_COMMENT, start);
+                break;
+            }
+            else if (i + 1 < length && data[i + 1] == '*') {
+                // Multi-line comment; an unterminated one runs to the end of the input
+                const char* close = findCommentEnd(data + i + 2, end);
+                i = close != end ? close - data + 2 : length;
+                if constexpr (Policy::keepComments) {
+                    return emit(TOK_COMMENT, start, LEX_COMMENT);
+                }
+                record(LEX_COMMENT, start);
+                break;
+            }
+            else {
+                TokenType type = TOK_OPERATOR;
+                i = munchOperator(data, i, length, type);
+                return emit(type, start, LEX_OPERATOR);
+            }
+
+        case CC_COLON:
+        case CC_OPERATOR:
+        case CC_PUNCT: {
+            // Operators and punctuators, longest spelling first (<<=, ->*, ...)
+            TokenType type = TOK_PUNCTUATION;
+            i = munchOperator(data, i, length, type);
+            return emit(type, start, LEX_OPERATOR);
+        }
+
+        case CC_DQUOTE:
+        case CC_SQUOTE:
+            // String and character literals, honoring backslash escapes
+            i++;
+            for (;;) {
+                i = findQuoteOrBackslash(data + i, end, current) - data;
+                if (i < length && data[i] == '\\') {
+                    i += (i + 1 < length) ? 2 : 1;
+                    continue;
+                }
+                break;
+            }
+            if (i < length) {
+                i++; // Closing quote
+            }
+            return emit(current == '"' ? TOK_STRING : TOK_CHAR, start, LEX_LITERAL);
+
+        default:
+            // Unknown characters
+            i++;
+            return emit(TOK_UNKNOWN, start, LEX_OTHER);
+        }
+    }
+
+    cursor_ = i;
+    return TokenSpan{ TOK_EOF, static_cast<uint32_t>(length), 0 };
+}
+
+// Construct a lexer over source, starting at byte offset position
+template <typename Policy>
+BasicLexer<Policy>::BasicLexer(std::string_view source, size_t position)
+    : source_(source), cursor_(std::min(position, source.length())) {
+    if (source.length() > UINT32_MAX) {
+        throw std::length_error("Lexer: input larger than 4 GiB");
+    }
+}
+
+// Return the k-th upcoming token, lexing ahead as far as needed
+template <typename Policy>
+const TokenSpan& BasicLexer<Policy>::peek(size_t k) {
+    while (lookahead_.size() - head_ <= k) {
+        lookahead_.push_back(lex());
+    }
+    return lookahead_[head_ + k];
+}
+
+// Append every remaining token to out; the hot loop of tokenize()
+template <typename Policy>
+void BasicLexer<Policy>::drain(std::vector<TokenSpan>& out) {
+    while (head_ < lookahead_.size()) {
+        out.push_back(next());
+    }
+    for (TokenSpan token = lex(); token.type != TOK_EOF; token = lex()) {
+        out.push_back(token);
+    }
+}
+
+// Each policy gets its own copy of the loop above, with the dropped branches compiled out
+template class BasicLexer<LexPolicy<true, true>>;
+template class BasicLexer<LexPolicy<true, false>>;
+template class BasicLexer<LexPolicy<false, true>>;
+template class BasicLexer<LexPolicy<false, false>>;
+template class BasicLexer<LexPolicy<true, true, true>>;
+template class BasicLexer<LexPolicy<true, false, true>>;
+template class BasicLexer<LexPolicy<false, true, true>>;
+template class BasicLexer<LexPolicy<false, false, true>>;
@@ -0,0 +1,125 @@
+#include "lexerstats.h"
+#include <chrono>
+#include <cstdio>   // For snprintf
+#include <thread>   // For std::this_thread::sleep_for
+
+void LexerStats::merge(const LexerStats& other) {
+    for (size_t t = 0; t < TOKEN_TYPE_COUNT; t++) {
+        tokens[t] += other.tokens[t];
+        bytes[t] += other.bytes[t];
+    }
+    for (size_t b = 0; b < LEX_BRANCH_COUNT; b++) {
+        branchHits[b] += other.branchHits[b];
+        branchBytes[b] += other.branchBytes[b];
+        branchTicks[b] += other.branchTicks[b];
+    }
+}
+
+uint64_t LexerStats::totalTokens() const {
+    uint64_t total = 0;
+    for (uint64_t count : tokens) {
+        total += count;
+    }
+    return total;
+}
+
+uint64_t LexerStats::totalBytes() const {
+    uint64_t total = 0;
+    for (uint64_t count : bytes) {
+        total += count;
+    }
+    return total;
+}
+
+// Compare the timestamp counter against steady_clock over a short sleep
+double timestampFrequency() {
+#ifdef LEXERSTATS_RDTSC
+    static const double frequency = [] {
+        auto clockBegin = std::chrono::steady_clock::now();
+        uint64_t ticksBegin = readTimestamp();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t ticks = readTimestamp() - ticksBegin;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - clockBegin).count();
+        return ticks / seconds;
+    }();
+    return frequency;
+#else
+    return 1e9;
+#endif
+}
+
+const char* lexBranchName(LexBranch branch) {
+    switch (branch) {
+    case LEX_WHITESPACE: return "whitespace";
+    case LEX_COMMENT: return "comment";
+    case LEX_DIRECTIVE: return "directive";
+    case LEX_IDENTIFIER: return "identifier";
+    case LEX_KEYWORD: return "keyword";
+    case LEX_NUMBER: return "number";
+    case LEX_OPERATOR: return "operator";
+    case LEX_LITERAL: return "literal";
+    case LEX_OTHER: return "other";
+    default: return "unknown";
+    }
+}
+
+// Append printf-style text to out: measure it first, then format in place,
+// so output of any length (long padding, long type names) is never cut short
+template <typename... Args>
+static void appendf(std::string& out, const char* format, Args... args) {
+    int length = snprintf(nullptr, 0, format, args...);
+    if (length <= 0) {
+        return;
+    }
+    size_t at = out.size();
+    out.resize(at + length + 1);  // Room for the terminator snprintf always writes
+    snprintf(&out[at], length + 1, format, args...);
+    out.resize(at + length);
+}
+
+std::string lexerStatsJson(const LexerStats& stats, int indent) {
+    std::string pad(indent, ' ');
+    std::string out;
+    uint64_t totalTokens = stats.totalTokens();
+    uint64_t totalTicks = 0;
+    for (uint64_t ticks : stats.branchTicks) {
+        totalTicks += ticks;
+    }
+    double nanosPerTick = 1e9 / timestampFrequency();
+
+    appendf(out, "{\n%s  \"tokens\": %llu,\n%s  \"token_bytes\": %llu,\n%s  \"average_token_length\": %.2f,\n",
+        pad.c_str(), static_cast<unsigned long long>(totalTokens),
+        pad.c_str(), static_cast<unsigned long long>(stats.totalBytes()),
+        pad.c_str(), totalTokens ? double(stats.totalBytes()) / totalTokens : 0.0);
+
+    // Only the types that occurred
+    appendf(out, "%s  \"types\": {", pad.c_str());
+    const char* separator = "\n";
+    for (size_t t = 0; t < TOKEN_TYPE_COUNT; t++) {
+        if (!stats.tokens[t]) {
+            continue;
+        }
+        std::string_view name = tokenTypeName(static_cast<TokenType>(t));
+        appendf(out, "%s%s    \"%.*s\": {\"tokens\": %llu, \"bytes\": %llu, \"average_length\": %.2f}",
+            separator, pad.c_str(), static_cast<int>(name.length()), name.data(),
+            static_cast<unsigned long long>(stats.tokens[t]), static_cast<unsigned long long>(stats.bytes[t]),
+            double(stats.bytes[t]) / stats.tokens[t]);
+        separator = ",\n";
+    }
+    appendf(out, "\n%s  },\n%s  \"branches\": {", pad.c_str(), pad.c_str());
+
+    separator = "\n";
+    for (size_t b = 0; b < LEX_BRANCH_COUNT; b++) {
+        uint64_t hits = stats.branchHits[b];
+        appendf(out, "%s%s    \"%s\": {\"hits\": %llu, \"bytes\": %llu, \"average_length\": %.2f, "
+            "\"ns\": %.0f, \"time_share\": %.4f}",
+            separator, pad.c_str(), lexBranchName(static_cast<LexBranch>(b)),
+            static_cast<unsigned long long>(hits), static_cast<unsigned long long>(stats.branchBytes[b]),
+            hits ? double(stats.branchBytes[b]) / hits : 0.0,
+            stats.branchTicks[b] * nanosPerTick,
+            totalTicks ? double(stats.branchTicks[b]) / totalTicks : 0.0);
+        separator = ",\n";
+    }
+    appendf(out, "\n%s  }\n%s}", pad.c_str(), pad.c_str());
+    return out;
+}
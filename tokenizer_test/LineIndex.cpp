@@ -0,0 +1,52 @@
+#include "lineindex.h"
+#include "scan.h"
+#include <algorithm> // For std::upper_bound
+
+void LineIndex::reset(std::string_view source) {
+    source_ = source;
+    starts_.clear();
+}
+
+// Record every line start with the same newline kernel the lexer uses for // comments
+void LineIndex::build() const {
+    starts_.push_back(0);
+    const char* begin = source_.data();
+    const char* end = begin + source_.length();
+    for (const char* p = findLineEnd(begin, end); p < end; p = findLineEnd(p + 1, end)) {
+        if (p + 1 < end) {
+            starts_.push_back(static_cast<uint32_t>(p + 1 - begin));
+        }
+    }
+}
+
+SourceLocation LineIndex::locate(size_t offset) const {
+    if (starts_.empty()) {
+        build();
+    }
+    offset = std::min(offset, source_.length());
+    auto next = std::upper_bound(starts_.begin(), starts_.end(), offset);
+    size_t line = next - starts_.begin();  // starts_[0] is 0, so line >= 1
+    return SourceLocation{ static_cast<uint32_t>(line), static_cast<uint32_t>(offset - starts_[line - 1] + 1) };
+}
+
+size_t LineIndex::lineCount() const {
+    if (starts_.empty()) {
+        build();
+    }
+    return source_.empty() ? 0 : starts_.size();
+}
+
+std::string_view LineIndex::lineText(uint32_t line) const {
+    if (line == 0 || line > lineCount()) {
+        return std::string_view();
+    }
+    size_t start = starts_[line - 1];
+    size_t end = line < starts_.size() ? starts_[line] - 1 : source_.length();
+    if (end > start && source_[end - 1] == '\n') {
+        end--;  // Last line ending in a newline
+    }
+    if (end > start && source_[end - 1] == '\r') {
+        end--;
+    }
+    return source_.substr(start, end - start);
+}
@@ -0,0 +1,228 @@
+#include "mappedfile.h"
+#include <cerrno>       // For errno
+#include <system_error> // For std::system_error
+#include <utility>      // For std::exchange
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+// Read a pipe or character device to its end, closing the handle
+static std::vector<char> readStream(HANDLE file, const std::string& path) {
+    std::vector<char> contents;
+    size_t length = 0;
+    for (;;) {
+        contents.resize(length + 65536);
+        DWORD got = 0;
+        if (!ReadFile(file, contents.data() + length, 65536, &got, nullptr)) {
+            DWORD error = GetLastError();
+            if (error == ERROR_BROKEN_PIPE) {
+                break;  // The writer closed its end
+            }
+            CloseHandle(file);
+            throw std::system_error(static_cast<int>(error), std::system_category(), "cannot read " + path);
+        }
+        if (got == 0) {
+            break;
+        }
+        length += got;
+    }
+    CloseHandle(file);
+    contents.resize(length);
+    return contents;
+}
+
+// Map a file with CreateFileMapping/MapViewOfFile
+MappedFile::MappedFile(const std::string& path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "cannot open " + path);
+    }
+
+    // Only disk files can be mapped
+    if (GetFileType(file) != FILE_TYPE_DISK) {
+        buffer_ = readStream(file, path);
+        if (!buffer_.empty()) {
+            data_ = buffer_.data();
+            size_ = buffer_.size();
+        }
+        return;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        DWORD error = GetLastError();
+        CloseHandle(file);
+        throw std::system_error(static_cast<int>(error), std::system_category(), "cannot stat " + path);
+    }
+
+    // Zero-length files cannot be mapped; they keep the empty default view
+    if (fileSize.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        DWORD error = GetLastError();
+        CloseHandle(file);
+        if (!mapping) {
+            throw std::system_error(static_cast<int>(error), std::system_category(), "cannot map " + path);
+        }
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!view) {
+            error = GetLastError();
+            CloseHandle(mapping);
+            throw std::system_error(static_cast<int>(error), std::system_category(), "cannot map " + path);
+        }
+        mapping_ = mapping;
+        data_ = static_cast<const char*>(view);
+        size_ = static_cast<size_t>(fileSize.QuadPart);
+        mapped_ = true;
+    }
+    else {
+        CloseHandle(file);
+    }
+}
+
+void MappedFile::close() {
+    if (mapped_) {
+        UnmapViewOfFile(data_);
+        CloseHandle(static_cast<HANDLE>(mapping_));
+    }
+    data_ = "";
+    size_ = 0;
+    mapped_ = false;
+    mapping_ = nullptr;
+    buffer_ = std::vector<char>();
+}
+
+// Moving a vector keeps its data pointer, so data_ stays valid for read files
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, "")), size_(std::exchange(other.size_, 0)),
+      mapped_(std::exchange(other.mapped_, false)), buffer_(std::move(other.buffer_)),
+      mapping_(std::exchange(other.mapping_, nullptr)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = std::exchange(other.data_, "");
+        size_ = std::exchange(other.size_, 0);
+        mapped_ = std::exchange(other.mapped_, false);
+        buffer_ = std::move(other.buffer_);
+        mapping_ = std::exchange(other.mapping_, nullptr);
+    }
+    return *this;
+}
+
+#else
+
+// Read a file descriptor to its end, closing it
+static std::vector<char> readStream(int fd, const std::string& path) {
+    std::vector<char> contents;
+    size_t length = 0;
+    for (;;) {
+        contents.resize(length + 65536);
+        ssize_t got = ::read(fd, contents.data() + length, 65536);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got < 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "cannot read " + path);
+        }
+        if (got == 0) {
+            break;
+        }
+        length += static_cast<size_t>(got);
+    }
+    ::close(fd);
+    contents.resize(length);
+    return contents;
+}
+
+// Map a file with mmap(PROT_READ)
+MappedFile::MappedFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "cannot stat " + path);
+    }
+
+    // Only regular files can be mapped. Pipes and devices are read instead, and
+    // so is a regular file of size zero, which may be a procfs file with contents.
+    // A directory fails in read() with EISDIR.
+    if (!S_ISREG(info.st_mode) || info.st_size == 0) {
+        buffer_ = readStream(fd, path);
+        if (!buffer_.empty()) {
+            data_ = buffer_.data();
+            size_ = buffer_.size();
+        }
+        return;
+    }
+
+    size_t size = static_cast<size_t>(info.st_size);
+    void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int error = errno;
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        throw std::system_error(error, std::generic_category(), "cannot map " + path);
+    }
+    // The lexer reads front to back exactly once
+    madvise(view, size, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(view);
+    size_ = size;
+    mapped_ = true;
+}
+
+void MappedFile::close() {
+    if (mapped_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = "";
+    size_ = 0;
+    mapped_ = false;
+    buffer_ = std::vector<char>();
+}
+
+// Moving a vector keeps its data pointer, so data_ stays valid for read files
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, "")), size_(std::exchange(other.size_, 0)),
+      mapped_(std::exchange(other.mapped_, false)), buffer_(std::move(other.buffer_)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = std::exchange(other.data_, "");
+        size_ = std::exchange(other.size_, 0);
+        mapped_ = std::exchange(other.mapped_, false);
+        buffer_ = std::move(other.buffer_);
+    }
+    return *this;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+// Map the file and lex directly out of the mapping
+TokenizedFile tokenizeFile(const std::string& path) {
+    TokenizedFile result;
+    result.file = MappedFile(path);
+    tokenize(result.file.view(), result.tokens);
+    return result;
+}
@@ -0,0 +1,98 @@
+#include "parallel.h"
+#include "lexer.h"
+#include <algorithm> // For std::min, std::max
+#include <cstring>   // For memchr
+#include <functional> // For std::ref
+#include <thread>
+
+// Tokens a worker lexed speculatively for one chunk
+struct ChunkTokens {
+    size_t begin = 0;               // First byte of the chunk
+    size_t end = 0;                 // One past the last byte of the chunk
+    std::vector<TokenSpan> tokens;  // Tokens starting in [begin, end), lexed as if begin were a token boundary
+};
+
+// Lex one chunk assuming the lexer is in its start state at chunk.begin
+static void lexChunk(std::string_view input, ChunkTokens& chunk) {
+    Lexer lexer(input, chunk.begin);
+    for (TokenSpan token = lexer.next(); token.type != TOK_EOF && token.offset < chunk.end; token = lexer.next()) {
+        chunk.tokens.push_back(token);
+    }
+}
+
+// Split points start a line where possible; lines rarely begin inside a
+// comment or literal, so most speculative starts are already correct.
+static size_t chunkStart(std::string_view input, size_t guess, size_t limit) {
+    const void* newline = memchr(input.data() + guess, '\n', limit - guess);
+    return newline ? static_cast<const char*>(newline) - input.data() + 1 : guess;
+}
+
+void tokenizeParallel(std::string_view input, std::vector<TokenSpan>& tokens, const ParallelOptions& options) {
+    size_t threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    size_t minChunk = std::max<size_t>(options.minChunkBytes, 1);
+    size_t chunkCount = std::min(threads, input.length() / minChunk);
+    if (chunkCount < 2) {
+        tokenize(input, tokens);
+        return;
+    }
+
+    // Chunk boundaries
+    std::vector<ChunkTokens> chunks(chunkCount);
+    size_t step = input.length() / chunkCount;
+    for (size_t k = 0; k < chunkCount; k++) {
+        size_t guess = k * step;
+        chunks[k].begin = k == 0 ? 0 : chunkStart(input, guess, std::min(guess + step, input.length()));
+    }
+    for (size_t k = 0; k < chunkCount; k++) {
+        chunks[k].end = k + 1 < chunkCount ? chunks[k + 1].begin : input.length();
+    }
+
+    // Speculative pass: chunk 0 on this thread, the rest on workers
+    std::vector<std::thread> workers;
+    workers.reserve(chunkCount - 1);
+    for (size_t k = 1; k < chunkCount; k++) {
+        workers.emplace_back(lexChunk, input, std::ref(chunks[k]));
+    }
+    lexChunk(input, chunks[0]);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    // Stitch: chunk 0 started at a true boundary; each later chunk is accepted
+    // from the first token start the true lexer shares with it.
+    size_t total = 0;
+    for (const ChunkTokens& chunk : chunks) {
+        total += chunk.tokens.size();
+    }
+    tokens.reserve(tokens.size() + total);
+    tokens.insert(tokens.end(), chunks[0].tokens.begin(), chunks[0].tokens.end());
+
+    size_t resume = chunks[0].tokens.empty() ? 0 : chunks[0].tokens.back().offset + chunks[0].tokens.back().length;
+    for (size_t k = 1; k < chunkCount; k++) {
+        const std::vector<TokenSpan>& speculative = chunks[k].tokens;
+        Lexer truth(input, resume);
+        size_t j = 0;
+
+        for (;;) {
+            TokenSpan token = truth.next();
+            if (token.type == TOK_EOF) {
+                return;
+            }
+            if (token.offset >= chunks[k].end) {
+                // Walked through the whole chunk without meeting it; the next chunk picks up here
+                resume = token.offset;
+                break;
+            }
+            while (j < speculative.size() && speculative[j].offset < token.offset) {
+                j++;
+            }
+            if (j < speculative.size() && speculative[j].offset == token.offset) {
+                tokens.insert(tokens.end(), speculative.begin() + j, speculative.end());
+                resume = speculative.back().offset + speculative.back().length;
+                break;
+            }
+            tokens.push_back(token);
+            resume = token.offset + token.length;
+        }
+    }
+}
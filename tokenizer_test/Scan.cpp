@@ -0,0 +1,408 @@
+#include "scan.h"
+#include <atomic>  // For the active kernel table
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SCAN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX2 instructions inside functions that opt in
+#if defined(SCAN_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SCAN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SCAN_TARGET_AVX2
+#endif
+
+// Table of kernel entry points for one ScanLevel
+struct ScanKernels {
+    const char* (*skipWhitespace)(const char*, const char*);
+    const char* (*skipIdentifier)(const char*, const char*);
+    const char* (*findLineEnd)(const char*, const char*);
+    const char* (*findCommentEnd)(const char*, const char*);
+    const char* (*findQuoteOrBackslash)(const char*, const char*, char);
+    const char* (*findDirectiveOrLiteral)(const char*, const char*);
+};
+
+// ---------------------------------------------------------------------------
+// Scalar kernels (also used for the tails of the vector kernels)
+
+static inline bool isSpaceByte(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline bool isIdentByte(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static const char* scalarSkipWhitespace(const char* p, const char* end) {
+    while (p < end && isSpaceByte(static_cast<unsigned char>(*p))) {
+        p++;
+    }
+    return p;
+}
+
+static const char* scalarSkipIdentifier(const char* p, const char* end) {
+    while (p < end && isIdentByte(static_cast<unsigned char>(*p))) {
+        p++;
+    }
+    return p;
+}
+
+static const char* scalarFindLineEnd(const char* p, const char* end) {
+    while (p < end && *p != '\n') {
+        p++;
+    }
+    return p;
+}
+
+static const char* scalarFindCommentEnd(const char* p, const char* end) {
+    while (p + 1 < end) {
+        if (p[0] == '*' && p[1] == '/') {
+            return p;
+        }
+        p++;
+    }
+    return end;
+}
+
+static const char* scalarFindQuoteOrBackslash(const char* p, const char* end, char quote) {
+    while (p < end && *p != quote && *p != '\\') {
+        p++;
+    }
+    return p;
+}
+
+static inline bool isDirectiveOrLiteralByte(char c) {
+    return c == '#' || c == '/' || c == '"' || c == '\'';
+}
+
+static const char* scalarFindDirectiveOrLiteral(const char* p, const char* end) {
+    while (p < end && !isDirectiveOrLiteralByte(*p)) {
+        p++;
+    }
+    return p;
+}
+
+static const ScanKernels scalarKernels = {
+    scalarSkipWhitespace, scalarSkipIdentifier, scalarFindLineEnd,
+    scalarFindCommentEnd, scalarFindQuoteOrBackslash, scalarFindDirectiveOrLiteral
+};
+
+#ifdef SCAN_X86
+
+// Index of the lowest set bit; mask must be non-zero
+static inline unsigned lowestBit(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// SSE2 kernels: 16 bytes per step. Signed byte compares are fine here since
+// every byte >= 0x80 is negative and therefore outside all the ranges tested.
+
+static inline __m128i sse2InRange(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1))), _mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+
+static const char* sse2SkipWhitespace(const char* p, const char* end) {
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i space = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), sse2InRange(v, '\t', '\r'));
+        uint32_t miss = ~static_cast<uint32_t>(_mm_movemask_epi8(space)) & 0xFFFF;
+        if (miss) {
+            return p + lowestBit(miss);
+        }
+        p += 16;
+    }
+    return scalarSkipWhitespace(p, end);
+}
+
+static const char* sse2SkipIdentifier(const char* p, const char* end) {
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i ident = _mm_or_si128(
+            _mm_or_si128(sse2InRange(lower, 'a', 'z'), sse2InRange(v, '0', '9')),
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+        uint32_t miss = ~static_cast<uint32_t>(_mm_movemask_epi8(ident)) & 0xFFFF;
+        if (miss) {
+            return p + lowestBit(miss);
+        }
+        p += 16;
+    }
+    return scalarSkipIdentifier(p, end);
+}
+
+static const char* sse2FindLineEnd(const char* p, const char* end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        uint32_t hit = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)));
+        if (hit) {
+            return p + lowestBit(hit);
+        }
+        p += 16;
+    }
+    return scalarFindLineEnd(p, end);
+}
+
+static const char* sse2FindCommentEnd(const char* p, const char* end) {
+    const __m128i star = _mm_set1_epi8('*');
+    const __m128i slash = _mm_set1_epi8('/');
+    // Compare each byte and its successor: needs 17 readable bytes per step
+    while (end - p >= 17) {
+        __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        uint32_t hit = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(first, star), _mm_cmpeq_epi8(second, slash))));
+        if (hit) {
+            return p + lowestBit(hit);
+        }
+        p += 16;
+    }
+    return scalarFindCommentEnd(p, end);
+}
+
+static const char* sse2FindQuoteOrBackslash(const char* p, const char* end, char quote) {
+    const __m128i q = _mm_set1_epi8(quote);
+    const __m128i backslash = _mm_set1_epi8('\\');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        uint32_t hit = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(v, q), _mm_cmpeq_epi8(v, backslash))));
+        if (hit) {
+            return p + lowestBit(hit);
+        }
+        p += 16;
+    }
+    return scalarFindQuoteOrBackslash(p, end, quote);
+}
+
+static const char* sse2FindDirectiveOrLiteral(const char* p, const char* end) {
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hash = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('#')), _mm_cmpeq_epi8(v, _mm_set1_epi8('/')));
+        __m128i quote = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\'')));
+        uint32_t hit = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(hash, quote)));
+        if (hit) {
+            return p + lowestBit(hit);
+        }
+        p += 16;
+    }
+    return scalarFindDirectiveOrLiteral(p, end);
+}
+
+static const ScanKernels sse2Kernels = {
+    sse2SkipWhitespace, sse2SkipIdentifier, sse2FindLineEnd,
+    sse2FindCommentEnd, sse2FindQuoteOrBackslash, sse2FindDirectiveOrLiteral
+};
+
+// ---------------------------------------------------------------------------
+// AVX2 kernels: 32 bytes per step, SSE2 for the remainder
+
+SCAN_TARGET_AVX2 static inline __m256i avx2InRange(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1))), _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v));
+}
+
+SCAN_TARGET_AVX2 static const char* avx2SkipWhitespace(const char* p, const char* end) {
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), avx2InRange(v, '\t', '\r'));
+        uint32_t miss = ~static_cast<uint32_t>(_mm256_movemask_epi8(space));
+        if (miss) {
+            return p + lowestBit(miss);
+        }
+        p += 32;
+    }
+    return sse2SkipWhitespace(p, end);
+}
+
+SCAN_TARGET_AVX2 static const char* avx2SkipIdentifier(const char* p, const char* end) {
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i ident = _mm256_or_si256(
+            _mm256_or_si256(avx2InRange(lower, 'a', 'z'), avx2InRange(v, '0', '9')),
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+        uint32_t miss = ~static_cast<uint32_t>(_mm256_movemask_epi8(ident));
+        if (miss) {
+            return p + lowestBit(miss);
+        }
+        p += 32;
+    }
+    return sse2SkipIdentifier(p, end);
+}
+
+SCAN_TARGET_AVX2 static const char* avx2FindLineEnd(const char* p, const char* end) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t hit = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline)));
+        if (hit) {
+            return p + lowestBit(hit);
+        }
+        p += 32;
+    }
+    return sse2FindLineEnd(p, end);
+}
+
+SCAN_TARGET_AVX2 static const char* avx2FindCommentEnd(const char* p, const char* end) {
+    const __m256i star = _mm256_set1_epi8('*');
+    const __m256i slash = _mm256_set1_epi8('/');
+    while (end - p >= 33) {
+        __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+        uint32_t hit = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(first, star), _mm256_cmpeq_epi8(second, slash))));
+        if (hit) {
+            return p + lowestBit(hit);
+        }
+        p += 32;
+    }
+    return sse2FindCommentEnd(p, end);
+}
+
+SCAN_TARGET_AVX2 static const char* avx2FindQuoteOrBackslash(const char* p, const char* end, char quote) {
+    const __m256i q = _mm256_set1_epi8(quote);
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t hit = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, q), _mm256_cmpeq_epi8(v, backslash))));
+        if (hit) {
+            return p + lowestBit(hit);
+        }
+        p += 32;
+    }
+    return sse2FindQuoteOrBackslash(p, end, quote);
+}
+
+SCAN_TARGET_AVX2 static const char* avx2FindDirectiveOrLiteral(const char* p, const char* end) {
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hash = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('#')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('/')));
+        __m256i quote = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\'')));
+        uint32_t hit = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(hash, quote)));
+        if (hit) {
+            return p + lowestBit(hit);
+        }
+        p += 32;
+    }
+    return sse2FindDirectiveOrLiteral(p, end);
+}
+
+static const ScanKernels avx2Kernels = {
+    avx2SkipWhitespace, avx2SkipIdentifier, avx2FindLineEnd,
+    avx2FindCommentEnd, avx2FindQuoteOrBackslash, avx2FindDirectiveOrLiteral
+};
+
+// Check CPUID and the OS-enabled register state for AVX2
+static bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // SCAN_X86
+
+// Kernel table for a level the CPU is known to support
+static const ScanKernels* kernelsFor(ScanLevel level) {
+#ifdef SCAN_X86
+    if (level == SCAN_AVX2) return &avx2Kernels;
+    if (level == SCAN_SSE2) return &sse2Kernels;
+#endif
+    (void)level;
+    return &scalarKernels;
+}
+
+static std::atomic<const ScanKernels*> activeKernels{ nullptr };
+static std::atomic<int> activeLevel{ -1 };
+
+// Select the kernels on first use
+static inline const ScanKernels& kernels() {
+    const ScanKernels* k = activeKernels.load(std::memory_order_relaxed);
+    if (!k) {
+        setScanLevel(bestScanLevel());
+        k = activeKernels.load(std::memory_order_relaxed);
+    }
+    return *k;
+}
+
+ScanLevel bestScanLevel() {
+#ifdef SCAN_X86
+    static const ScanLevel best = cpuHasAvx2() ? SCAN_AVX2 : SCAN_SSE2;
+    return best;
+#else
+    return SCAN_SCALAR;
+#endif
+}
+
+ScanLevel activeScanLevel() {
+    kernels();
+    return static_cast<ScanLevel>(activeLevel.load(std::memory_order_relaxed));
+}
+
+bool setScanLevel(ScanLevel level) {
+    if (level < SCAN_SCALAR || level > bestScanLevel()) {
+        return false;
+    }
+    activeLevel.store(level, std::memory_order_relaxed);
+    activeKernels.store(kernelsFor(level), std::memory_order_relaxed);
+    return true;
+}
+
+const char* scanLevelName(ScanLevel level) {
+    switch (level) {
+    case SCAN_SCALAR: return "scalar";
+    case SCAN_SSE2: return "sse2";
+    case SCAN_AVX2: return "avx2";
+    default: return "unknown";
+    }
+}
+
+const char* skipWhitespace(const char* p, const char* end) {
+    return kernels().skipWhitespace(p, end);
+}
+
+const char* skipIdentifier(const char* p, const char* end) {
+    return kernels().skipIdentifier(p, end);
+}
+
+const char* findLineEnd(const char* p, const char* end) {
+    return kernels().findLineEnd(p, end);
+}
+
+const char* findCommentEnd(const char* p, const char* end) {
+    return kernels().findCommentEnd(p, end);
+}
+
+const char* findQuoteOrBackslash(const char* p, const char* end, char quote) {
+    return kernels().findQuoteOrBackslash(p, end, quote);
+}
+
+const char* findDirectiveOrLiteral(const char* p, const char* end) {
+    return kernels().findDirectiveOrLiteral(p, end);
+}
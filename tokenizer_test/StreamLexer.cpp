@@ -0,0 +1,454 @@
+#include "streamlexer.h"
+#include "directive.h"
+#include "lexer.h"
+#include "scan.h"
+
+// True for the bytes that continue an identifier or a pp-number: A-Z, a-z, 0-9, _
+static inline bool isWordByte(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Lex a chunk, first finishing the token the previous chunk left in progress
+void StreamLexer::feed(std::string_view chunk, std::vector<StreamToken>& out) {
+    chunkBase_ = consumed_;
+    consumed_ += chunk.length();
+    done_.clear();
+    owned_.clear();
+
+    size_t i = state_ == STATE_NONE ? 0 : resume(chunk, false, out);
+    if (state_ == STATE_NONE) {
+        lexChunk(chunk, i, out);
+    }
+    for (const OwnedText& text : owned_) {
+        out[text.index].text = std::string_view(done_.data() + text.offset, text.length);
+    }
+}
+
+// With no more input coming the token in progress ends here
+void StreamLexer::finish(std::vector<StreamToken>& out) {
+    chunkBase_ = consumed_;
+    done_.clear();
+    owned_.clear();
+
+    resume(std::string_view(), true, out);
+    for (const OwnedText& text : owned_) {
+        out[text.index].text = std::string_view(done_.data() + text.offset, text.length);
+    }
+}
+
+void StreamLexer::reset() {
+    state_ = STATE_NONE;
+    part_ = PART_PLAIN;
+    escape_ = false;
+    star_ = false;
+    quotePending_ = false;
+    carry_.clear();
+    done_.clear();
+    owned_.clear();
+    carryOffset_ = 0;
+    chunkBase_ = 0;
+    consumed_ = 0;
+}
+
+void StreamLexer::lexChunk(std::string_view chunk, size_t i, std::vector<StreamToken>& out) {
+    size_t safe = chunk.length() > lookahead ? chunk.length() - lookahead : 0;
+    Lexer lexer(chunk, i);
+    for (TokenSpan token = lexer.next(); token.type != TOK_EOF; token = lexer.next()) {
+        if (token.offset + token.length > safe && !settle(chunk, token)) {
+            // Anything the Lexer found after it lies inside the carried bytes
+            carry_.assign(chunk.substr(token.offset));
+            carryOffset_ = chunkBase_ + token.offset;
+            return;
+        }
+        out.push_back(StreamToken{ token.type, chunkBase_ + token.offset, token.text(chunk) });
+    }
+}
+
+// Re-run the state machine over the token from its first byte. Only tokens
+// ending in the last few bytes get here, and of those only the one left open
+// is longer than a few bytes; its bytes in later chunks are not scanned twice.
+bool StreamLexer::settle(std::string_view chunk, const TokenSpan& token) {
+    size_t start = token.offset;
+    size_t i = start + 1;
+    char first = chunk[start];
+    tokenBegin_ = start;
+
+    if (token.type == TOK_UNKNOWN) {
+        return true;
+    }
+    else if (token.type == TOK_NUMBER) {
+        state_ = STATE_NUMBER;
+        quotePending_ = false;
+    }
+    else if (isWordByte(first)) {
+        state_ = STATE_WORD;
+    }
+    else if (first == '#') {
+        state_ = STATE_DIRECTIVE;
+        part_ = PART_PLAIN;
+    }
+    else if (first == '"' || first == '\'') {
+        state_ = STATE_LITERAL;
+        quote_ = first;
+        escape_ = false;
+    }
+    else if (token.type == TOK_COMMENT) {
+        state_ = chunk[start + 1] == '/' ? STATE_LINE_COMMENT : STATE_BLOCK_COMMENT;
+        star_ = false;
+        i = start + 2;
+    }
+    else {
+        // An operator is final unless the rest of the chunk could still grow into a longer one
+        if (!operatorCanExtend(chunk.substr(start))) {
+            return true;
+        }
+        state_ = STATE_OPERATOR;
+        return false;
+    }
+
+    if (advance(chunk, i) == ADVANCE_OPEN) {
+        return false;
+    }
+    state_ = STATE_NONE;
+    return true;
+}
+
+size_t StreamLexer::resume(std::string_view chunk, bool final, std::vector<StreamToken>& out) {
+    size_t i = 0;
+    tokenBegin_ = 0;
+    while (state_ != STATE_NONE) {
+        if (state_ == STATE_OPERATOR) {
+            if (resolveOperator(chunk, i, final, out) == ADVANCE_OPEN) {
+                break;
+            }
+            continue;
+        }
+
+        Advance result;
+        if (final) {
+            // Unterminated tokens run to the end of the input
+            result = state_ == STATE_NUMBER && quotePending_ ? ADVANCE_SPLIT : ADVANCE_DONE;
+        }
+        else {
+            result = advance(chunk, i);
+        }
+
+        if (result == ADVANCE_OPEN) {
+            carry_.append(chunk.substr(tokenBegin_));
+            break;
+        }
+        if (result == ADVANCE_SPLIT) {
+            // The number ends before its trailing quote, which opens a char literal instead
+            std::string_view number(carry_.data(), carry_.size() - 1);
+            emitOwned(TOK_NUMBER, carryOffset_, number, out);
+            carryOffset_ += number.length();
+            carry_.assign(1, '\'');
+            quotePending_ = false;
+            state_ = STATE_LITERAL;
+            quote_ = '\'';
+            escape_ = false;
+            tokenBegin_ = i;
+            continue;
+        }
+        completeToken(chunk, i, out);
+    }
+    return i;
+}
+
+StreamLexer::Advance StreamLexer::advance(std::string_view chunk, size_t& i) {
+    const char* data = chunk.data();
+    const char* end = data + chunk.length();
+    size_t length = chunk.length();
+
+    switch (state_) {
+    case STATE_WORD:
+        i = skipIdentifier(data + i, end) - data;
+        return i < length ? ADVANCE_DONE : ADVANCE_OPEN;
+
+    case STATE_NUMBER:
+        if (quotePending_) {
+            if (i == length) {
+                return ADVANCE_OPEN;
+            }
+            if (!isWordByte(data[i])) {
+                return ADVANCE_SPLIT;
+            }
+            quotePending_ = false;
+            i++;
+        }
+        while (i < length) {
+            char c = data[i];
+            if (isWordByte(c) || c == '.') {
+                i++;
+            }
+            else if ((c == '+' || c == '-') &&
+                ((byteBefore(chunk, i, 1) | 0x20) == 'e' || (byteBefore(chunk, i, 1) | 0x20) == 'p')) {
+                i++;
+            }
+            else if (c == '\'' && i + 1 == length) {
+                // A separator only if a digit or letter follows, which the next chunk decides
+                quotePending_ = true;
+                i = length;
+                return ADVANCE_OPEN;
+            }
+            else if (c == '\'' && isWordByte(data[i + 1])) {
+                i += 2;
+            }
+            else {
+                return ADVANCE_DONE;
+            }
+        }
+        return ADVANCE_OPEN;
+
+    case STATE_LINE_COMMENT:
+        i = findLineEnd(data + i, end) - data;
+        return i < length ? ADVANCE_DONE : ADVANCE_OPEN;
+
+    case STATE_BLOCK_COMMENT: {
+        if (star_ && i < length && data[i] == '/') {
+            star_ = false;
+            i++;
+            return ADVANCE_DONE;
+        }
+        const char* close = findCommentEnd(data + i, end);
+        if (close != end) {
+            star_ = false;
+            i = close - data + 2;
+            return ADVANCE_DONE;
+        }
+        if (i < length) {
+            star_ = data[length - 1] == '*';
+        }
+        i = length;
+        return ADVANCE_OPEN;
+    }
+
+    case STATE_LITERAL:
+        if (escape_) {
+            if (i == length) {
+                return ADVANCE_OPEN;
+            }
+            escape_ = false;
+            i++;
+        }
+        for (;;) {
+            i = findQuoteOrBackslash(data + i, end, quote_) - data;
+            if (i == length) {
+                return ADVANCE_OPEN;
+            }
+            if (data[i] == quote_) {
+                i++;
+                return ADVANCE_DONE;
+            }
+            if (i + 1 == length) {
+                escape_ = true;
+                i = length;
+                return ADVANCE_OPEN;
+            }
+            i += 2;
+        }
+
+    case STATE_DIRECTIVE:
+        return advanceDirective(chunk, i);
+
+    default:
+        return ADVANCE_DONE;
+    }
+}
+
+// The directiveEnd() rules, one byte at a time so that the scan can stop
+// anywhere: the directive ends at a newline not preceded by a backslash,
+// and comments and quoted runs inside it hide the newlines they contain
+StreamLexer::Advance StreamLexer::advanceDirective(std::string_view chunk, size_t& i) {
+    const char* data = chunk.data();
+    const char* end = data + chunk.length();
+    size_t length = chunk.length();
+
+    while (i < length) {
+        char c = data[i];
+        switch (part_) {
+        case PART_PLAIN:
+            if (c == '\n') {
+                // The directive starts with '#', so the bytes looked at here belong to it
+                char last = byteBefore(chunk, i, 1);
+                if (last == '\\' || (last == '\r' && byteBefore(chunk, i, 2) == '\\')) {
+                    i++;
+                    continue;
+                }
+                return ADVANCE_DONE;
+            }
+            if (c == '/') {
+                part_ = PART_SLASH;
+            }
+            else if (c == '"' || c == '\'') {
+                part_ = PART_QUOTE;
+                quote_ = c;
+            }
+            i++;
+            break;
+
+        case PART_SLASH:
+            if (c == '*') {
+                part_ = PART_BLOCK_COMMENT;
+                star_ = false;
+                i++;
+            }
+            else if (c == '/') {
+                part_ = PART_LINE_COMMENT;
+                i++;
+            }
+            else {
+                part_ = PART_PLAIN;
+            }
+            break;
+
+        case PART_LINE_COMMENT:
+            // The newline ending the comment may still be continued, as in plain text
+            i = findLineEnd(data + i, end) - data;
+            if (i < length) {
+                part_ = PART_PLAIN;
+            }
+            break;
+
+        case PART_BLOCK_COMMENT: {
+            if (star_ && c == '/') {
+                star_ = false;
+                part_ = PART_PLAIN;
+                i++;
+                break;
+            }
+            const char* close = findCommentEnd(data + i, end);
+            if (close != end) {
+                star_ = false;
+                part_ = PART_PLAIN;
+                i = close - data + 2;
+                break;
+            }
+            star_ = data[length - 1] == '*';
+            i = length;
+            break;
+        }
+
+        case PART_QUOTE:
+            if (c == quote_) {
+                part_ = PART_PLAIN;
+                i++;
+            }
+            else if (c == '\n') {
+                part_ = PART_PLAIN;
+            }
+            else {
+                if (c == '\\') {
+                    part_ = PART_QUOTE_ESCAPE;
+                }
+                i++;
+            }
+            break;
+
+        case PART_QUOTE_ESCAPE:
+            // A backslash takes the next byte, and a "\r\n" pair as one
+            part_ = c == '\r' ? PART_QUOTE_ESCAPE_CR : PART_QUOTE;
+            i++;
+            break;
+
+        case PART_QUOTE_ESCAPE_CR:
+            part_ = PART_QUOTE;
+            if (c == '\n') {
+                i++;
+            }
+            break;
+        }
+    }
+    return ADVANCE_OPEN;
+}
+
+StreamLexer::Advance StreamLexer::resolveOperator(std::string_view chunk, size_t& i, bool final,
+    std::vector<StreamToken>& out) {
+    // No spelling is longer than three bytes, so a few bytes of chunk settle it
+    std::string probe = carry_;
+    probe.append(chunk.substr(i, 3));
+
+    if (probe.length() >= 2 && probe[0] == '/' && (probe[1] == '/' || probe[1] == '*')) {
+        // carry_ is the "/" of a comment opener
+        state_ = probe[1] == '/' ? STATE_LINE_COMMENT : STATE_BLOCK_COMMENT;
+        star_ = false;
+        tokenBegin_ = i;
+        i++;
+        return ADVANCE_DONE;
+    }
+    if (probe.length() >= 2 && probe[0] == '.' && probe[1] >= '0' && probe[1] <= '9') {
+        // carry_ is the "." of a number; the number scan takes the digit
+        state_ = STATE_NUMBER;
+        quotePending_ = false;
+        tokenBegin_ = i;
+        return ADVANCE_DONE;
+    }
+    if (!final && operatorCanExtend(probe)) {
+        carry_.append(chunk.substr(i));
+        i = chunk.length();
+        return ADVANCE_OPEN;
+    }
+
+    TokenType type = TOK_PUNCTUATION;
+    size_t n = matchOperator(probe, 0, type);
+    emitOwned(type, carryOffset_, std::string_view(probe).substr(0, n), out);
+    if (n < carry_.size()) {
+        // Only ".." backs off, leaving its second "." to settle in turn
+        carry_.erase(0, n);
+        carryOffset_ += n;
+        return ADVANCE_DONE;
+    }
+    i += n - carry_.size();
+    carry_.clear();
+    state_ = STATE_NONE;
+    return ADVANCE_DONE;
+}
+
+char StreamLexer::byteBefore(std::string_view chunk, size_t i, size_t back) const {
+    if (i >= tokenBegin_ + back) {
+        return chunk[i - back];
+    }
+    return carry_[carry_.size() - (tokenBegin_ + back - i)];
+}
+
+void StreamLexer::emitOwned(TokenType type, uint64_t offset, std::string_view text, std::vector<StreamToken>& out) {
+    owned_.push_back(OwnedText{ out.size(), done_.size(), text.length() });
+    done_.append(text);
+    out.push_back(StreamToken{ type, offset, std::string_view() });
+}
+
+void StreamLexer::completeToken(std::string_view chunk, size_t end, std::vector<StreamToken>& out) {
+    size_t at = done_.size();
+    if (at == 0) {
+        // The usual case: take the carried bytes over rather than copying them
+        done_.swap(carry_);
+    }
+    else {
+        done_.append(carry_);
+    }
+    done_.append(chunk.substr(tokenBegin_, end - tokenBegin_));
+    std::string_view text(done_.data() + at, done_.size() - at);
+
+    TokenType type = TOK_COMMENT;
+    switch (state_) {
+    case STATE_WORD:
+        type = classifyWord(text);
+        break;
+    case STATE_NUMBER:
+        type = TOK_NUMBER;
+        break;
+    case STATE_LITERAL:
+        type = quote_ == '"' ? TOK_STRING : TOK_CHAR;
+        break;
+    case STATE_DIRECTIVE:
+        type = directiveType(directiveName(text));
+        break;
+    default:
+        break;
+    }
+    owned_.push_back(OwnedText{ out.size(), at, text.length() });
+    out.push_back(StreamToken{ type, carryOffset_, std::string_view() });
+
+    carry_.clear();
+    state_ = STATE_NONE;
+}
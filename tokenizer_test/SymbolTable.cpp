@@ -0,0 +1,128 @@
+#include "symboltable.h"
+#include <stdexcept> // For std::length_error
+
+// 64-bit FNV-1a; identifiers are short, so a simple byte loop is enough
+static uint64_t hashName(std::string_view name) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : name) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Locate id within the doubling segments: segment k holds firstSegment << k ids
+static void locate(SymbolId id, size_t firstSegment, size_t& segment, size_t& index) {
+    size_t block = id / firstSegment + 1;
+    segment = 0;
+    while (block >> (segment + 1)) {
+        segment++;
+    }
+    index = id - firstSegment * ((size_t(1) << segment) - 1);
+}
+
+SymbolTable::SymbolTable() : next_(0), published_(0) {
+    for (auto& segment : segments_) {
+        segment.store(nullptr, std::memory_order_relaxed);
+    }
+    for (Shard& shard : shards_) {
+        shard.slots.assign(64, Slot{ 0, NO_SYMBOL });
+    }
+}
+
+SymbolTable::~SymbolTable() {
+    for (auto& segment : segments_) {
+        delete[] segment.load(std::memory_order_relaxed);
+    }
+}
+
+// Probe a shard for name; the shard lock must be held
+SymbolId SymbolTable::findLocked(const Shard& shard, std::string_view name, uint64_t hash) const {
+    size_t mask = shard.slots.size() - 1;
+    uint32_t tag = static_cast<uint32_t>(hash);
+    for (size_t k = static_cast<size_t>(hash) & mask;; k = (k + 1) & mask) {
+        const Slot& slot = shard.slots[k];
+        if (slot.id == NO_SYMBOL) {
+            return NO_SYMBOL;
+        }
+        if (slot.hash == tag && text(slot.id) == name) {
+            return slot.id;
+        }
+    }
+}
+
+// Store the text of a new id, allocating its segment on first use
+void SymbolTable::publish(SymbolId id, std::string_view name) {
+    size_t segment, index;
+    locate(id, firstSegment, segment, index);
+
+    std::string_view* entries = segments_[segment].load(std::memory_order_acquire);
+    if (!entries) {
+        // Several shards may race to create the same segment; one wins
+        std::string_view* fresh = new std::string_view[firstSegment << segment];
+        if (segments_[segment].compare_exchange_strong(entries, fresh, std::memory_order_acq_rel)) {
+            entries = fresh;
+        }
+        else {
+            delete[] fresh;
+        }
+    }
+    entries[index] = name;
+}
+
+SymbolId SymbolTable::intern(std::string_view name) {
+    uint64_t hash = hashName(name);
+    Shard& shard = shards_[hash >> 60];
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    SymbolId id = findLocked(shard, name, hash);
+    if (id != NO_SYMBOL) {
+        return id;
+    }
+
+    id = next_.fetch_add(1, std::memory_order_acq_rel);
+    if (id == NO_SYMBOL) {
+        throw std::length_error("SymbolTable is full");
+    }
+    publish(id, shard.names.copy(name));
+    published_.fetch_add(1, std::memory_order_release);
+
+    // Keep the load factor at or below one half; the low hash bits kept in
+    // each slot are enough to re-place it, so names are not hashed again
+    if (++shard.used * 2 > shard.slots.size()) {
+        std::vector<Slot> old(shard.slots.size() * 2, Slot{ 0, NO_SYMBOL });
+        old.swap(shard.slots);
+        size_t mask = shard.slots.size() - 1;
+        for (const Slot& slot : old) {
+            if (slot.id == NO_SYMBOL) {
+                continue;
+            }
+            size_t k = slot.hash & mask;
+            while (shard.slots[k].id != NO_SYMBOL) {
+                k = (k + 1) & mask;
+            }
+            shard.slots[k] = slot;
+        }
+    }
+
+    size_t mask = shard.slots.size() - 1;
+    size_t k = static_cast<size_t>(hash) & mask;
+    while (shard.slots[k].id != NO_SYMBOL) {
+        k = (k + 1) & mask;
+    }
+    shard.slots[k] = Slot{ static_cast<uint32_t>(hash), id };
+    return id;
+}
+
+SymbolId SymbolTable::find(std::string_view name) const {
+    uint64_t hash = hashName(name);
+    const Shard& shard = shards_[hash >> 60];
+    std::lock_guard<std::mutex> guard(shard.lock);
+    return findLocked(shard, name, hash);
+}
+
+// Ids only reach callers after publish(), so the entry is already written
+std::string_view SymbolTable::text(SymbolId id) const {
+    size_t segment, index;
+    locate(id, firstSegment, segment, index);
+    return segments_[segment].load(std::memory_order_acquire)[index];
+}
@@ -0,0 +1,190 @@
+#include "tokenbinary.h"
+#include <array>     // For the valid type table
+#include <cstring>   // For memcmp
+#include <stdexcept> // For std::runtime_error
+
+static const char TOKB_MAGIC[4] = { 'T', 'O', 'K', 'B' };
+static const uint8_t TOKB_VERSION = 1;
+static const size_t TOKB_HEADER = 6;
+
+// Type bytes a token record may carry, as one table load per record
+static constexpr std::array<bool, 256> buildValidTypes() {
+    std::array<bool, 256> valid{};
+    for (uint32_t t = 0; t < 256; t++) {
+        valid[t] = isTokenType(t);
+    }
+    return valid;
+}
+
+static constexpr std::array<bool, 256> validTypes = buildValidTypes();
+
+// Append v as a LEB128 varint: seven bits per byte, high bit set on all but the last
+static void putVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+void writeTokens(std::string_view source, const TokenSpan* tokens, size_t count, std::string& out, bool withValues) {
+    out.append(TOKB_MAGIC, sizeof(TOKB_MAGIC));
+    out.push_back(static_cast<char>(TOKB_VERSION));
+    out.push_back(static_cast<char>(withValues ? TOKB_VALUES : 0));
+    putVarint(out, source.length());
+    putVarint(out, count);
+
+    // Records go to a scratch buffer first so their byte size can precede them
+    std::string records;
+    records.reserve(count * 3);
+    uint64_t end = 0;
+    for (size_t i = 0; i < count; i++) {
+        const TokenSpan& token = tokens[i];
+        records.push_back(static_cast<char>(token.type));
+        putVarint(records, token.offset - end);
+        putVarint(records, token.length);
+        end = uint64_t(token.offset) + token.length;
+    }
+    putVarint(out, records.size());
+    out += records;
+
+    if (!withValues) {
+        return;
+    }
+
+    // Value table: only literals whose contents differ from their body
+    std::vector<size_t> escaped;
+    for (size_t i = 0; i < count; i++) {
+        if (tokens[i].type == TOK_STRING || tokens[i].type == TOK_CHAR) {
+            if (literalBody(tokens[i].text(source)).find('\\') != std::string_view::npos) {
+                escaped.push_back(i);
+            }
+        }
+    }
+    putVarint(out, escaped.size());
+    std::string decoded;
+    size_t previous = 0;
+    for (size_t i : escaped) {
+        std::string_view text = tokens[i].text(source);
+        decoded.resize(literalBody(text).length());
+        decoded.resize(unescapeLiteral(text, &decoded[0]));
+        putVarint(out, i - previous);
+        putVarint(out, decoded.size());
+        out += decoded;
+        previous = i;
+    }
+}
+
+TokenReader::TokenReader(std::string_view data) : data_(data) {
+    if (data.length() < TOKB_HEADER || memcmp(data.data(), TOKB_MAGIC, sizeof(TOKB_MAGIC)) != 0) {
+        throw std::runtime_error("TokenReader: not a token stream");
+    }
+    if (static_cast<uint8_t>(data[4]) != TOKB_VERSION) {
+        throw std::runtime_error("TokenReader: unsupported format version");
+    }
+    flags_ = static_cast<uint8_t>(data[5]);
+
+    size_t cursor = TOKB_HEADER;
+    uint64_t sourceLength = readVarint(cursor, data.length());
+    if (sourceLength > UINT32_MAX) {
+        throw std::runtime_error("TokenReader: source larger than 4 GiB");
+    }
+    sourceLength_ = static_cast<size_t>(sourceLength);
+    count_ = static_cast<size_t>(readVarint(cursor, data.length()));
+    uint64_t recordBytes = readVarint(cursor, data.length());
+    if (recordBytes > data.length() - cursor) {
+        throw std::runtime_error("TokenReader: truncated records");
+    }
+    if (count_ > recordBytes / 3) {
+        throw std::runtime_error("TokenReader: token count does not match the records");
+    }
+    recordsBegin_ = cursor;
+    recordsEnd_ = cursor + static_cast<size_t>(recordBytes);
+    valuesBegin_ = recordsEnd_;
+    rewind();
+}
+
+uint64_t TokenReader::readVarint(size_t& cursor, size_t limit) const {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (cursor >= limit) {
+            throw std::runtime_error("TokenReader: truncated varint");
+        }
+        uint8_t byte = static_cast<uint8_t>(data_[cursor++]);
+        value |= uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("TokenReader: varint too long");
+}
+
+// Read the next value table entry, if any, into nextValueIndex_/nextValue_
+void TokenReader::loadNextValue() {
+    if (valuesLeft_ == 0) {
+        nextValueIndex_ = count_;
+        return;
+    }
+    valuesLeft_--;
+    nextValueIndex_ += static_cast<size_t>(readVarint(valueCursor_, data_.length()));
+    uint64_t length = readVarint(valueCursor_, data_.length());
+    if (length > data_.length() - valueCursor_) {
+        throw std::runtime_error("TokenReader: truncated value");
+    }
+    nextValue_ = data_.substr(valueCursor_, static_cast<size_t>(length));
+    valueCursor_ += static_cast<size_t>(length);
+}
+
+void TokenReader::rewind() {
+    cursor_ = recordsBegin_;
+    index_ = 0;
+    end_ = 0;
+    nextValueIndex_ = 0;
+    valuesLeft_ = 0;
+    if (hasValues()) {
+        valueCursor_ = valuesBegin_;
+        valuesLeft_ = static_cast<size_t>(readVarint(valueCursor_, data_.length()));
+    }
+    loadNextValue();
+}
+
+bool TokenReader::next(DecodedToken& token) {
+    if (index_ == count_) {
+        return false;
+    }
+    if (cursor_ >= recordsEnd_) {
+        throw std::runtime_error("TokenReader: truncated records");
+    }
+    uint8_t type = static_cast<uint8_t>(data_[cursor_++]);
+    if (!validTypes[type]) {
+        throw std::runtime_error("TokenReader: invalid token type");
+    }
+    token.type = static_cast<TokenType>(type);
+    uint64_t gap = readVarint(cursor_, recordsEnd_);
+    uint64_t length = readVarint(cursor_, recordsEnd_);
+    if (gap > sourceLength_ - end_ || length > sourceLength_ - end_ - gap) {
+        throw std::runtime_error("TokenReader: token outside the source");
+    }
+    uint64_t offset = end_ + gap;
+    token.offset = static_cast<uint32_t>(offset);
+    token.length = static_cast<uint32_t>(length);
+    end_ = offset + length;
+
+    token.hasValue = index_ == nextValueIndex_;
+    token.value = token.hasValue ? nextValue_ : std::string_view();
+    if (token.hasValue) {
+        loadNextValue();
+    }
+    index_++;
+    return true;
+}
+
+void TokenReader::readAll(std::vector<TokenSpan>& out) {
+    rewind();
+    out.clear();
+    out.reserve(count_);
+    DecodedToken token;
+    while (next(token)) {
+        out.push_back(TokenSpan{ token.type, token.offset, token.length });
+    }
+}
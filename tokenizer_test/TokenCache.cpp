@@ -0,0 +1,317 @@
+#include "tokencache.h"
+#include "lexer.h"       // For LEXER_VERSION
+#include <algorithm>     // For std::min
+#include <atomic>
+#include <cerrno>        // For errno
+#include <cstdio>        // For snprintf
+#include <cstring>       // For memcpy, memcmp
+#include <filesystem>
+#include <system_error>
+#include <type_traits>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Layout of an entry: this header, then tokenCount TokenSpan records
+struct CacheHeader {
+    char magic[8];          // "TOKCACHE"
+    uint32_t format;        // CACHE_FORMAT
+    uint32_t lexerVersion;  // LEXER_VERSION of the writer
+    uint32_t byteOrder;     // BYTE_ORDER_MARK as the writer stored it
+    uint32_t recordSize;    // sizeof(TokenSpan) of the writer
+    uint64_t sourceHash;    // hashBytes() of the source
+    uint64_t sourceLength;  // Source length in bytes
+    uint64_t tokenCount;    // Records following the header
+};
+
+static const char CACHE_MAGIC[8] = { 'T', 'O', 'K', 'C', 'A', 'C', 'H', 'E' };
+static const uint32_t CACHE_FORMAT = 1;
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// Records are stored as raw TokenSpans and read in place from the mapping
+static_assert(sizeof(CacheHeader) == 48, "CacheHeader must have no padding");
+static_assert(sizeof(CacheHeader) % alignof(TokenSpan) == 0, "records must be aligned in the mapping");
+static_assert(std::is_trivially_copyable<TokenSpan>::value, "TokenSpan must be stored byte for byte");
+
+// XXH64: four independent 64-bit lanes over 32-byte stripes, then a tail and an avalanche
+static const uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t PRIME3 = 0x165667B19E3779F9ull;
+static const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t PRIME5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const unsigned char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t read32(const unsigned char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t round64(uint64_t acc, uint64_t input) {
+    acc += input * PRIME2;
+    return rotl(acc, 31) * PRIME1;
+}
+
+static inline uint64_t mergeRound(uint64_t acc, uint64_t lane) {
+    acc ^= round64(0, lane);
+    return acc * PRIME1 + PRIME4;
+}
+
+uint64_t hashBytes(const void* data, size_t length, uint64_t seed) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + length;
+    uint64_t h;
+
+    if (length >= 32) {
+        uint64_t v1 = seed + PRIME1 + PRIME2;
+        uint64_t v2 = seed + PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME1;
+        const unsigned char* limit = end - 32;
+        do {
+            v1 = round64(v1, read64(p));
+            v2 = round64(v2, read64(p + 8));
+            v3 = round64(v3, read64(p + 16));
+            v4 = round64(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    }
+    else {
+        h = seed + PRIME5;
+    }
+
+    h += static_cast<uint64_t>(length);
+    for (; p + 8 <= end; p += 8) {
+        h ^= round64(0, read64(p));
+        h = rotl(h, 27) * PRIME1 + PRIME4;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(read32(p)) * PRIME1;
+        h = rotl(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= *p * PRIME5;
+        h = rotl(h, 11) * PRIME1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+TokenCache::TokenCache(std::string directory) : directory_(std::move(directory)) {
+    std::filesystem::create_directories(directory_);
+}
+
+// Entries are named by hash and lexer version, so a version bump starts a fresh set of names
+std::string TokenCache::entryPath(uint64_t hash) const {
+    char name[48];
+    snprintf(name, sizeof(name), "%016llx-v%u.tok", static_cast<unsigned long long>(hash), LEXER_VERSION);
+    return (std::filesystem::path(directory_) / name).string();
+}
+
+// Check records read from disk before anyone indexes a source with them: each
+// must have a real type and lie inside the source, after the one before it
+static bool validRecords(const TokenSpan* tokens, size_t count, uint64_t sourceLength) {
+    uint64_t end = 0;
+    for (size_t i = 0; i < count; i++) {
+        std::underlying_type<TokenType>::type type;
+        memcpy(&type, &tokens[i].type, sizeof(type));
+        if (!isTokenType(static_cast<uint32_t>(type)) || tokens[i].offset < end ||
+            uint64_t(tokens[i].offset) + tokens[i].length > sourceLength) {
+            return false;
+        }
+        end = uint64_t(tokens[i].offset) + tokens[i].length;
+    }
+    return true;
+}
+
+// Map an entry and point out at its records; false if it is missing, stale or damaged
+bool TokenCache::load(const std::string& path, uint64_t hash, size_t length, CachedTokens& out) const {
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(path, ec)) {
+        return false;
+    }
+
+    MappedFile entry;
+    try {
+        entry = MappedFile(path);
+    }
+    catch (const std::system_error&) {
+        return false;
+    }
+
+    if (entry.size() < sizeof(CacheHeader)) {
+        return false;
+    }
+    CacheHeader header;
+    memcpy(&header, entry.data(), sizeof(header));
+    if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.format != CACHE_FORMAT ||
+        header.lexerVersion != LEXER_VERSION ||
+        header.byteOrder != BYTE_ORDER_MARK ||
+        header.recordSize != sizeof(TokenSpan) ||
+        header.sourceHash != hash ||
+        header.sourceLength != length) {
+        return false;
+    }
+    // Divide rather than multiply, so no tokenCount can wrap around to a plausible size
+    size_t recordBytes = entry.size() - sizeof(CacheHeader);
+    if (recordBytes % sizeof(TokenSpan) != 0 || header.tokenCount != recordBytes / sizeof(TokenSpan)) {
+        return false;
+    }
+    const TokenSpan* tokens = reinterpret_cast<const TokenSpan*>(entry.data() + sizeof(CacheHeader));
+    if (!validRecords(tokens, static_cast<size_t>(header.tokenCount), length)) {
+        return false;
+    }
+
+    out.entry = std::move(entry);
+    out.tokens = reinterpret_cast<const TokenSpan*>(out.entry.data() + sizeof(CacheHeader));
+    out.count = static_cast<size_t>(header.tokenCount);
+    out.hit = true;
+    return true;
+}
+
+// Write the entry to a file created under name, failing rather than opening one
+// that already exists (O_EXCL, CREATE_NEW); taken says whether that was why
+static bool writeNewFile(const std::string& name, const CacheHeader& header, const std::vector<TokenSpan>& tokens,
+    bool& taken) {
+    const char* parts[2] = { reinterpret_cast<const char*>(&header), reinterpret_cast<const char*>(tokens.data()) };
+    size_t sizes[2] = { sizeof(header), tokens.size() * sizeof(TokenSpan) };
+    bool ok = true;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(name.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        taken = GetLastError() == ERROR_FILE_EXISTS;
+        return false;
+    }
+    for (int k = 0; k < 2 && ok; k++) {
+        const char* p = parts[k];
+        size_t left = sizes[k];
+        while (ok && left) {
+            DWORD chunk = static_cast<DWORD>(std::min<size_t>(left, 1u << 30));
+            DWORD done = 0;
+            ok = WriteFile(file, p, chunk, &done, nullptr) && done == chunk;
+            p += chunk;
+            left -= chunk;
+        }
+    }
+    return CloseHandle(file) && ok;
+#else
+    int fd = open(name.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        taken = errno == EEXIST;
+        return false;
+    }
+    for (int k = 0; k < 2 && ok; k++) {
+        const char* p = parts[k];
+        size_t left = sizes[k];
+        while (ok && left) {
+            ssize_t done = write(fd, p, left);
+            if (done < 0 && errno == EINTR) {
+                continue;
+            }
+            ok = done > 0;
+            if (ok) {
+                p += done;
+                left -= static_cast<size_t>(done);
+            }
+        }
+    }
+    return close(fd) == 0 && ok;
+#endif
+}
+
+// Write an entry under a temporary name no other writer can be using, then
+// rename it into place. The name carries the process id and a per-process
+// counter; the exclusive create catches a stale file left by a crashed
+// process whose id has been reused, and the next counter value is tried.
+void TokenCache::store(const std::string& path, uint64_t hash, size_t length, const std::vector<TokenSpan>& tokens) {
+    CacheHeader header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.format = CACHE_FORMAT;
+    header.lexerVersion = LEXER_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.recordSize = sizeof(TokenSpan);
+    header.sourceHash = hash;
+    header.sourceLength = length;
+    header.tokenCount = tokens.size();
+
+    static std::atomic<uint64_t> counter(0);
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = static_cast<unsigned long>(getpid());
+#endif
+
+    std::string temporary;
+    bool written = false;
+    bool taken = true;
+    for (int attempt = 0; attempt < 8 && !written && taken; attempt++) {
+        taken = false;
+        temporary = path + "." + std::to_string(pid) + "." + std::to_string(counter.fetch_add(1)) + ".tmp";
+        written = writeNewFile(temporary, header, tokens, taken);
+    }
+
+    std::error_code ec;
+    if (written) {
+        std::filesystem::rename(temporary, path, ec);
+    }
+    if (!written || ec) {
+        if (!taken) {
+            // Never delete a name that some other writer created
+            std::filesystem::remove(temporary, ec);
+        }
+        stats_.writeFailures++;
+    }
+}
+
+CachedTokens TokenCache::tokenize(std::string_view source) {
+    uint64_t hash = hashBytes(source.data(), source.length());
+    std::string path = entryPath(hash);
+
+    CachedTokens result;
+    if (load(path, hash, source.length(), result)) {
+        stats_.hits++;
+        return result;
+    }
+
+    stats_.misses++;
+    ::tokenize(source, result.lexed);
+    store(path, hash, source.length(), result.lexed);
+    result.tokens = result.lexed.data();
+    result.count = result.lexed.size();
+    return result;
+}
+
+CachedFile TokenCache::tokenizeFile(const std::string& path) {
+    CachedFile result;
+    result.file = MappedFile(path);
+    result.tokens = tokenize(result.file.view());
+    return result;
+}
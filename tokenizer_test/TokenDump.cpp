@@ -0,0 +1,186 @@
+#include "tokendump.h"
+#include <algorithm> // For std::max
+#include <cerrno>
+#include <charconv>  // For std::to_chars
+#include <cstring>   // For memcpy
+#include <system_error>
+
+// Longest line a token can produce beyond its escaped text: type name, two
+// 20-digit numbers and the JSON keys and punctuation
+static const size_t LINE_OVERHEAD = 128;
+
+// An escaped byte takes at most six ("\u001f")
+static const size_t MAX_ESCAPE = 6;
+
+// Smallest batch: room for the longest line overhead several times over
+static const size_t MIN_BATCH = 4 * LINE_OVERHEAD;
+
+bool parseDumpFormat(std::string_view name, DumpFormat& format) {
+    if (name == "text") {
+        format = DUMP_TEXT;
+    }
+    else if (name == "tsv") {
+        format = DUMP_TSV;
+    }
+    else if (name == "json") {
+        format = DUMP_JSON;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+TokenDumpWriter::TokenDumpWriter(std::FILE* out, DumpFormat format, size_t batchSize)
+    : out_(out), format_(format), batchSize_(std::max(batchSize, MIN_BATCH)), buffer_(batchSize_) {
+    if (format_ == DUMP_TSV) {
+        static const char header[] = "type\toffset\tlength\ttext\n";
+        memcpy(reserve(sizeof(header) - 1), header, sizeof(header) - 1);
+        used_ += sizeof(header) - 1;
+    }
+}
+
+char* TokenDumpWriter::reserve(size_t n) {
+    if (buffer_.size() - used_ < n) {
+        if (used_ && std::fwrite(buffer_.data(), 1, used_, out_) != used_) {
+            throw std::system_error(errno, std::generic_category(), "write");
+        }
+        used_ = 0;
+    }
+    return buffer_.data() + used_;
+}
+
+static char* put(char* out, std::string_view text) {
+    memcpy(out, text.data(), text.length());
+    return out + text.length();
+}
+
+static char* putNumber(char* out, uint64_t value) {
+    return std::to_chars(out, out + 20, value).ptr;
+}
+
+// Copy text with the TSV field and row separators escaped
+static char* putTsvText(char* out, std::string_view text) {
+    for (char c : text) {
+        if (c == '\t' || c == '\n' || c == '\r' || c == '\\') {
+            *out++ = '\\';
+            c = c == '\t' ? 't' : c == '\n' ? 'n' : c == '\r' ? 'r' : '\\';
+        }
+        *out++ = c;
+    }
+    return out;
+}
+
+// Copy text as the contents of a JSON string. Bytes of 0x80 and up pass
+// through, so the output is valid JSON whenever the source is valid UTF-8.
+static char* putJsonText(char* out, std::string_view text) {
+    static const char hex[] = "0123456789abcdef";
+    for (char c : text) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (byte >= 0x20 && c != '"' && c != '\\') {
+            *out++ = c;
+            continue;
+        }
+        *out++ = '\\';
+        switch (c) {
+        case '"': *out++ = '"'; break;
+        case '\\': *out++ = '\\'; break;
+        case '\n': *out++ = 'n'; break;
+        case '\r': *out++ = 'r'; break;
+        case '\t': *out++ = 't'; break;
+        default:
+            out = put(out, "u00");
+            *out++ = hex[byte >> 4];
+            *out++ = hex[byte & 15];
+            break;
+        }
+    }
+    return out;
+}
+
+// Everything before the token text: type name, and offset and length except in DUMP_TEXT
+static char* putHead(char* out, DumpFormat format, std::string_view name, uint64_t offset, size_t length) {
+    switch (format) {
+    case DUMP_TEXT:
+        out = put(out, name);
+        *out++ = ' ';
+        break;
+    case DUMP_TSV:
+        out = put(out, name);
+        *out++ = '\t';
+        out = putNumber(out, offset);
+        *out++ = '\t';
+        out = putNumber(out, length);
+        *out++ = '\t';
+        break;
+    case DUMP_JSON:
+        out = put(out, "{\"type\":\"");
+        out = put(out, name);
+        out = put(out, "\",\"offset\":");
+        out = putNumber(out, offset);
+        out = put(out, ",\"length\":");
+        out = putNumber(out, length);
+        out = put(out, ",\"text\":\"");
+        break;
+    }
+    return out;
+}
+
+static char* putText(char* out, DumpFormat format, std::string_view text) {
+    switch (format) {
+    case DUMP_TEXT:
+        return put(out, text);
+    case DUMP_TSV:
+        return putTsvText(out, text);
+    default:
+        return putJsonText(out, text);
+    }
+}
+
+static char* putTail(char* out, DumpFormat format) {
+    if (format == DUMP_JSON) {
+        out = put(out, "\"}");
+    }
+    *out++ = '\n';
+    return out;
+}
+
+void TokenDumpWriter::write(TokenType type, uint64_t offset, std::string_view text) {
+    std::string_view name = tokenTypeName(type);
+    size_t expansion = format_ == DUMP_TEXT ? 1 : MAX_ESCAPE;
+    size_t lineBytes = name.length() + text.length() * expansion + LINE_OVERHEAD;
+    if (lineBytes <= batchSize_) {
+        char* begin = reserve(lineBytes);
+        char* out = putHead(begin, format_, name, offset, text.length());
+        out = putText(out, format_, text);
+        out = putTail(out, format_);
+        used_ += out - begin;
+        return;
+    }
+
+    // A token larger than a batch goes out in batch-sized pieces, so one huge
+    // comment or literal does not leave the buffer permanently grown
+    char* begin = reserve(name.length() + LINE_OVERHEAD);
+    used_ += putHead(begin, format_, name, offset, text.length()) - begin;
+    size_t pieceLength = batchSize_ / expansion;
+    for (size_t i = 0; i < text.length(); i += pieceLength) {
+        std::string_view piece = text.substr(i, pieceLength);
+        begin = reserve(piece.length() * expansion);
+        used_ += putText(begin, format_, piece) - begin;
+    }
+    begin = reserve(LINE_OVERHEAD);
+    used_ += putTail(begin, format_) - begin;
+}
+
+void TokenDumpWriter::write(std::string_view source, const std::vector<TokenSpan>& tokens) {
+    for (const TokenSpan& token : tokens) {
+        write(token.type, token.offset, token.text(source));
+    }
+}
+
+void TokenDumpWriter::flush() {
+    if (std::fwrite(buffer_.data(), 1, used_, out_) != used_ || std::fflush(out_) != 0) {
+        throw std::system_error(errno, std::generic_category(), "write");
+    }
+    used_ = 0;
+}
@@ -0,0 +1,103 @@
+#include "tokenstream.h"
+#include "lexer.h"
+#include <algorithm> // For std::count, std::lower_bound
+#include <cstring>   // For memchr
+
+// Kinds are stored as single bytes
+static_assert(TOK_PP_LINE <= UINT8_MAX, "TokenType values must fit in the uint8_t kind array");
+
+// Construct a stream by lexing source
+TokenStream::TokenStream(std::string_view source) {
+    assign(source);
+}
+
+// Construct a stream from tokens lexed elsewhere
+TokenStream::TokenStream(std::string_view source, const std::vector<TokenSpan>& tokens) {
+    assign(source, tokens);
+}
+
+// Lex source straight into the per-field arrays
+void TokenStream::assign(std::string_view source) {
+    clear();
+    source_ = source;
+    lines_.reset(source);
+
+    Lexer lexer(source);
+    for (TokenSpan token = lexer.next(); token.type != TOK_EOF; token = lexer.next()) {
+        push(token);
+    }
+}
+
+void TokenStream::assign(std::string_view source, const std::vector<TokenSpan>& tokens) {
+    clear();
+    source_ = source;
+    lines_.reset(source);
+
+    kinds_.reserve(tokens.size());
+    offsets_.reserve(tokens.size());
+    lengths_.reserve(tokens.size());
+    for (const TokenSpan& token : tokens) {
+        push(token);
+    }
+}
+
+// Split a token across the arrays, parsing a number while its text is hot
+void TokenStream::push(const TokenSpan& token) {
+    if (token.type == TOK_NUMBER) {
+        numbers_.emplace_back();
+        parseNumber(token.text(source_), numbers_.back());
+        numberTokens_.push_back(static_cast<uint32_t>(kinds_.size()));
+    }
+    kinds_.push_back(static_cast<uint8_t>(token.type));
+    offsets_.push_back(token.offset);
+    lengths_.push_back(token.length);
+    if (!symbols_.empty()) {
+        symbols_.push_back(NO_SYMBOL);
+    }
+}
+
+// Drop all tokens but keep the array capacity for reuse
+void TokenStream::clear() {
+    source_ = std::string_view();
+    kinds_.clear();
+    offsets_.clear();
+    lengths_.clear();
+    lines_.reset(std::string_view());
+    symbols_.clear();
+    numbers_.clear();
+    numberTokens_.clear();
+}
+
+// Find a token's value by binary search over the number token indices
+const NumericValue* TokenStream::number(size_t i) const {
+    auto it = std::lower_bound(numberTokens_.begin(), numberTokens_.end(), i);
+    if (it == numberTokens_.end() || *it != i) {
+        return nullptr;
+    }
+    return &numbers_[it - numberTokens_.begin()];
+}
+
+// Give every identifier its symbol id; other tokens get NO_SYMBOL
+void TokenStream::intern(SymbolTable& table) {
+    symbols_.assign(kinds_.size(), NO_SYMBOL);
+    for (size_t i = 0; i < kinds_.size(); i++) {
+        if (kinds_[i] == TOK_IDENTIFIER) {
+            symbols_[i] = table.intern(text(i));
+        }
+    }
+}
+
+// Find the next token of a kind by scanning the byte-wide kind array
+size_t TokenStream::find(TokenType kind, size_t from) const {
+    if (from >= kinds_.size()) {
+        return kinds_.size();
+    }
+    const uint8_t* base = kinds_.data();
+    const void* hit = memchr(base + from, static_cast<uint8_t>(kind), kinds_.size() - from);
+    return hit ? static_cast<const uint8_t*>(hit) - base : kinds_.size();
+}
+
+// Count tokens of a kind
+size_t TokenStream::count(TokenType kind) const {
+    return std::count(kinds_.begin(), kinds_.end(), static_cast<uint8_t>(kind));
+}
@@ -1,24 +1,101 @@
-#include "Tokenizer.h"
-#include <cctype>  // For character checks (isdigit, isalpha, etc.)
+#include "tokenizer.h"
+#include "lexer.h"
 #include <iostream> // For debugging output (optional)
-#include <unordered_set> // For faster keyword lookup
+#include <utility>   // For std::move
+#include <cstring>  // For memcmp
+#include <charconv> // For std::from_chars
+#include <cstdlib>  // For strtod, strtof
 
 // Token constructor
-Token::Token(TokenType t, const std::string& val) : type(t), value(val) {}
-
-// Set of C++ keywords for quick lookup
-const std::unordered_set<std::string> keywords = {
-    "int", "float", "double", "bool", "return", "void", "namespace", "enum",
-    "if", "else", "for", "while", "do", "switch", "case", "break", "continue",
-    "default", "static", "const", "class", "struct", "public", "private", "protected",
-    "virtual", "override", "new", "delete", "try", "catch", "throw", "using", "asm",
-    "auto", "char", "extern", "friend", "inline", "long", "register", "signed", "short",
-    "this", "typedef", "union", "unsigned", "volatile", "template"
+Token::Token(TokenType t, std::string val, uint32_t off) : type(t), value(std::move(val)), offset(off) {}
+
+// Keyword spelling and the TokenType it lexes as ("template" has no dedicated type)
+struct KeywordSpec {
+    const char* text;
+    TokenType type;
+};
+
+static constexpr KeywordSpec keywordSpecs[] = {
+    { "int", TOK_INT }, { "float", TOK_FLOAT }, { "double", TOK_DOUBLE }, { "bool", TOK_BOOL },
+    { "return", TOK_RETURN }, { "void", TOK_VOID }, { "namespace", TOK_NAMESPACE },
+    { "enum", TOK_ENUM }, { "if", TOK_IF }, { "else", TOK_ELSE }, { "for", TOK_FOR },
+    { "while", TOK_WHILE }, { "do", TOK_DO }, { "switch", TOK_SWITCH }, { "case", TOK_CASE },
+    { "break", TOK_BREAK }, { "continue", TOK_CONTINUE }, { "default", TOK_DEFAULT },
+    { "static", TOK_STATIC }, { "const", TOK_CONST }, { "class", TOK_CLASS },
+    { "struct", TOK_STRUCT }, { "public", TOK_PUBLIC }, { "private", TOK_PRIVATE },
+    { "protected", TOK_PROTECTED }, { "virtual", TOK_VIRTUAL }, { "override", TOK_OVERRIDE },
+    { "new", TOK_NEW }, { "delete", TOK_DELETE }, { "try", TOK_TRY }, { "catch", TOK_CATCH },
+    { "throw", TOK_THROW }, { "using", TOK_USING }, { "asm", TOK_ASM }, { "auto", TOK_AUTO },
+    { "char", TOK_CHAR }, { "extern", TOK_EXTERN }, { "friend", TOK_FRIEND },
+    { "inline", TOK_INLINE }, { "long", TOK_LONG }, { "register", TOK_REGISTER },
+    { "signed", TOK_SIGNED }, { "short", TOK_SHORT }, { "this", TOK_THIS },
+    { "typedef", TOK_TYPEDEF }, { "union", TOK_UNION }, { "unsigned", TOK_UNSIGNED },
+    { "volatile", TOK_VOLATILE }, { "template", TOK_KEYWORD },
+};
+
+// One slot of the perfect-hash keyword table; empty slots have length 0
+struct KeywordEntry {
+    char text[10];
+    uint8_t length;
+    TokenType type;
+};
+
+struct KeywordTable {
+    KeywordEntry entries[128];
+    bool collisionFree;
 };
 
+// Perfect hash over the keyword set: first two bytes, last byte and length.
+// The multipliers were searched offline; buildKeywordTable() rejects any collision.
+static constexpr size_t keywordHash(const char* s, size_t n) {
+    return (static_cast<unsigned char>(s[0]) + static_cast<unsigned char>(s[1]) * 32 +
+        static_cast<unsigned char>(s[n - 1]) * 3 + n * 14) & 127;
+}
+
+// Build the keyword table at compile time
+static constexpr KeywordTable buildKeywordTable() {
+    KeywordTable table{};
+    table.collisionFree = true;
+    for (size_t k = 0; k < 128; k++) {
+        table.entries[k].type = TOK_IDENTIFIER;
+    }
+    for (const KeywordSpec& spec : keywordSpecs) {
+        size_t n = 0;
+        while (spec.text[n] != '\0') {
+            n++;
+        }
+        KeywordEntry& entry = table.entries[keywordHash(spec.text, n)];
+        if (entry.length != 0 || n >= sizeof(entry.text)) {
+            table.collisionFree = false;
+        }
+        for (size_t k = 0; k < n; k++) {
+            entry.text[k] = spec.text[k];
+        }
+        entry.length = static_cast<uint8_t>(n);
+        entry.type = spec.type;
+    }
+    return table;
+}
+
+static constexpr KeywordTable keywordTable = buildKeywordTable();
+static_assert(keywordTable.collisionFree, "keyword hash must be collision-free; re-tune keywordHash()");
+
+// Classify a word as a keyword TokenType or TOK_IDENTIFIER with one hash probe and one compare
+TokenType classifyWord(std::string_view word) {
+    size_t n = word.length();
+    if (n < 2 || n > 9) {
+        return TOK_IDENTIFIER;
+    }
+    const KeywordEntry& entry = keywordTable.entries[keywordHash(word.data(), n)];
+    if (entry.length == n && memcmp(entry.text, word.data(), n) == 0) {
+        return entry.type;
+    }
+    return TOK_IDENTIFIER;
+}
+
 // Check if a string is a keyword
-bool isKeyword(const std::string& str) {
-    return keywords.find(str) != keywords.end();
+bool isKeyword(std::string_view str) {
+    return classifyWord(str) != TOK_IDENTIFIER;
 }
 
 // Check if a character is a valid operator
@@ -28,311 +105,322 @@ bool isOperator(char c) {
         c == '^' || c == '%' || c == '~');
 }
 
-// Check for multi-character operators (e.g., <<, >>, <=, >=, ==, !=, ++, --, **)
-bool isMultiCharOperator(const std::string& input, size_t i) {
-    if (i + 1 >= input.length()) return false;
-    char next = input[i + 1];
-    char current = input[i];
-
-    return (current == '<' && next == '<') || (current == '>' && next == '>') ||
-        (current == '<' && next == '=') || (current == '>' && next == '=') ||
-        (current == '=' && next == '=') || (current == '!' && next == '=') ||
-        (current == '+' && next == '+') || (current == '-' && next == '-') ||
-        (current == '*' && next == '*');
+// Check for multi-character operators (e.g., <<=, &&, ->*, ...), as the lexer matches them
+bool isMultiCharOperator(std::string_view input, size_t i) {
+    TokenType type;
+    return matchOperator(input, i, type) > 1;
 }
 
 // Convert TokenType to string for debugging
 std::string tokenTypeToString(TokenType type) {
-    switch (type) {
-    case TOK_HEADER: return "TOK_HEADER";
-    case TOK_COMMENT: return "TOK_COMMENT";
-    case TOK_INT: return "TOK_INT";
-    case TOK_FLOAT: return "TOK_FLOAT";
-    case TOK_DOUBLE: return "TOK_DOUBLE";
-    case TOK_BOOL: return "TOK_BOOL";
-    case TOK_RETURN: return "TOK_RETURN";
-    case TOK_IDENTIFIER: return "TOK_IDENTIFIER";
-    case TOK_NUMBER: return "TOK_NUMBER";
-    case TOK_OPERATOR: return "TOK_OPERATOR";
-    case TOK_PUNCTUATION: return "TOK_PUNCTUATION";
-    case TOK_STRING: return "TOK_STRING";
-    case TOK_CHAR: return "TOK_CHAR";
-    case TOK_VOID: return "TOK_VOID";
-    case TOK_NAMESPACE: return "TOK_NAMESPACE";
-    case TOK_ENUM: return "TOK_ENUM";
-    case TOK_TEMPLATE: return "TOK_TEMPLATE";
-    case TOK_KEYWORD: return "TOK_KEYWORD";
-    case TOK_UNKNOWN: return "TOK_UNKNOWN";
-
-        // Add cases for all keyword token types
-    case TOK_IF: return "TOK_IF";
-    case TOK_ELSE: return "TOK_ELSE";
-    case TOK_FOR: return "TOK_FOR";
-    case TOK_WHILE: return "TOK_WHILE";
-    case TOK_DO: return "TOK_DO";
-    case TOK_SWITCH: return "TOK_SWITCH";
-    case TOK_CASE: return "TOK_CASE";
-    case TOK_BREAK: return "TOK_BREAK";
-    case TOK_CONTINUE: return "TOK_CONTINUE";
-    case TOK_DEFAULT: return "TOK_DEFAULT";
-    case TOK_STATIC: return "TOK_STATIC";
-    case TOK_CONST: return "TOK_CONST";
-    case TOK_CLASS: return "TOK_CLASS";
-    case TOK_STRUCT: return "TOK_STRUCT";
-    case TOK_PUBLIC: return "TOK_PUBLIC";
-    case TOK_PRIVATE: return "TOK_PRIVATE";
-    case TOK_PROTECTED: return "TOK_PROTECTED";
-    case TOK_VIRTUAL: return "TOK_VIRTUAL";
-    case TOK_OVERRIDE: return "TOK_OVERRIDE";
-    case TOK_NEW: return "TOK_NEW";
-    case TOK_DELETE: return "TOK_DELETE";
-    case TOK_TRY: return "TOK_TRY";
-    case TOK_CATCH: return "TOK_CATCH";
-    case TOK_THROW: return "TOK_THROW";
-    case TOK_USING: return "TOK_USING";
-    case TOK_ASM: return "TOK_ASM";
-    case TOK_AUTO: return "TOK_AUTO";
-    case TOK_EXTERN: return "TOK_EXTERN";
-    case TOK_FRIEND: return "TOK_FRIEND";
-    case TOK_INLINE: return "TOK_INLINE";
-    case TOK_LONG: return "TOK_LONG";
-    case TOK_REGISTER: return "TOK_REGISTER";
-    case TOK_SIGNED: return "TOK_SIGNED";
-    case TOK_SHORT: return "TOK_SHORT";
-    case TOK_THIS: return "TOK_THIS";
-    case TOK_TYPEDEF: return "TOK_TYPEDEF";
-    case TOK_UNION: return "TOK_UNION";
-    case TOK_UNSIGNED: return "TOK_UNSIGNED";
-    case TOK_VOLATILE: return "TOK_VOLATILE";
-    case TOK_SCOPE: return "TOK_SCOPE";
-    default: return "UNKNOWN";
-    }
+    return std::string(tokenTypeName(type));
 }
 
 
-// Tokenize input string
-std::vector<Token> tokenize(const std::string& input) {
-    std::vector<Token> tokens;
-    size_t length = input.length();
-    size_t i = 0;
-
-    while (i < length) {
-        char current = input[i];
+// Tokenize input into spans by draining a Lexer; no token text is copied
+void tokenize(std::string_view input, std::vector<TokenSpan>& tokens) {
+    tokenize<FullPolicy>(input, tokens);
+}
 
-        // Skip whitespace
-        if (isspace(current)) {
-            i++;
-            continue;
+// Strip the quotes from a literal token; an unterminated literal has only the opening one
+std::string_view literalBody(std::string_view literal) {
+    if (literal.empty()) {
+        return literal;
+    }
+    char quote = literal[0];
+    size_t end = literal.length();
+    if (end >= 2 && literal[end - 1] == quote) {
+        // The closing quote counts only if it is not itself escaped
+        size_t backslashes = 0;
+        while (end - 2 - backslashes > 0 && literal[end - 2 - backslashes] == '\\') {
+            backslashes++;
         }
-
-        // Handle preprocessor directives
-        if (current == '#') {
-            std::string directive;
-            while (i < length && input[i] != '\n') {
-                directive += input[i++];
-            }
-            tokens.push_back(Token(TOK_HEADER, directive));
-            continue;
+        if (backslashes % 2 == 0) {
+            return literal.substr(1, end - 2);
         }
+    }
+    return literal.substr(1);
+}
 
-        // Handle multi-character operators (e.g., ==, <=, ++, **)
-        if (isMultiCharOperator(input, i)) {
-            tokens.push_back(Token(TOK_OPERATOR, input.substr(i, 2)));  // Capture two-character operator
-            i += 2;
-            continue;
-        }
+// Value of a hex digit, or -1
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
 
-        // Handle single-line comments
-        if (current == '/' && i + 1 < length && input[i + 1] == '/') {
-            std::string comment;
-            while (i < length && input[i] != '\n') {
-                comment += input[i++];
-            }
-            tokens.push_back(Token(TOK_COMMENT, comment));
-            continue;
-        }
+// Append a code point as UTF-8; returns bytes written
+static size_t encodeUtf8(uint32_t code, char* out) {
+    if (code < 0x80) {
+        out[0] = static_cast<char>(code);
+        return 1;
+    }
+    if (code < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (code >> 6));
+        out[1] = static_cast<char>(0x80 | (code & 0x3F));
+        return 2;
+    }
+    if (code < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (code >> 12));
+        out[1] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (code & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | ((code >> 18) & 0x07));
+    out[1] = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (code & 0x3F));
+    return 4;
+}
 
-        // Handle Scope Resolutiona
-        if (current == ':' && i + 1 < length && input[i + 1] == ':') {
-            tokens.push_back(Token(TOK_SCOPE, "::"));
-            i += 2;
+// Decode escapes; every escape is at least as long as what it decodes to,
+// so the output never outgrows the literal body
+size_t unescapeLiteral(std::string_view literal, char* out) {
+    std::string_view body = literalBody(literal);
+    size_t length = body.length();
+    size_t written = 0;
+    size_t i = 0;
+
+    while (i < length) {
+        char c = body[i++];
+        if (c != '\\' || i == length) {
+            out[written++] = c;
             continue;
         }
 
-        // Handle multi-line comments
-        if (current == '/' && i + 1 < length && input[i + 1] == '*') {
-            std::string comment = "/*";
-            i += 2;
-            while (i + 1 < length && !(input[i] == '*' && input[i + 1] == '/')) {
-                comment += input[i++];
+        char escape = body[i++];
+        switch (escape) {
+        case 'n': out[written++] = '\n'; break;
+        case 't': out[written++] = '\t'; break;
+        case 'r': out[written++] = '\r'; break;
+        case 'a': out[written++] = '\a'; break;
+        case 'b': out[written++] = '\b'; break;
+        case 'f': out[written++] = '\f'; break;
+        case 'v': out[written++] = '\v'; break;
+        case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': {
+            // Up to three octal digits
+            unsigned value = escape - '0';
+            for (int digits = 1; digits < 3 && i < length && body[i] >= '0' && body[i] <= '7'; digits++) {
+                value = value * 8 + (body[i++] - '0');
             }
-            if (i + 1 < length) {
-                comment += "*/";
-                i += 2;
-            }
-            tokens.push_back(Token(TOK_COMMENT, comment));
-            continue;
+            out[written++] = static_cast<char>(value);
+            break;
         }
-
-        // Handle keywords, identifiers, and template keyword
-        if (isalpha(current) || current == '_') {
-            std::string word;
-            while (i < length && (isalnum(input[i]) || input[i] == '_')) {
-                word += input[i++];
+        case 'x': {
+            // Any number of hex digits; the value is truncated to a byte
+            unsigned value = 0;
+            size_t start = i;
+            while (i < length && hexValue(body[i]) >= 0) {
+                value = value * 16 + hexValue(body[i++]);
             }
-
-            if (isKeyword(word)) {
-                tokens.push_back(Token(wordToTokenType(word), word));
+            if (i == start) {
+                out[written++] = 'x';
             }
             else {
-                tokens.push_back(Token(TOK_IDENTIFIER, word));
+                out[written++] = static_cast<char>(value);
             }
-            continue;
+            break;
         }
-
-        // Handle numbers (integers and floats)
-        if (isdigit(current)) {
-            std::string number;
-            while (i < length && (isdigit(input[i]) || input[i] == '.')) {
-                number += input[i++];
+        case 'u':
+        case 'U': {
+            // Exactly 4 or 8 hex digits naming a Unicode scalar value (not a
+            // surrogate, which UTF-8 cannot encode), written as UTF-8
+            size_t digits = escape == 'u' ? 4 : 8;
+            uint32_t code = 0;
+            size_t k = 0;
+            while (k < digits && i + k < length && hexValue(body[i + k]) >= 0) {
+                code = code * 16 + hexValue(body[i + k]);
+                k++;
             }
-            tokens.push_back(Token(TOK_NUMBER, number));
-            continue;
+            if (k == digits && code <= 0x10FFFF && (code < 0xD800 || code > 0xDFFF)) {
+                written += encodeUtf8(code, out + written);
+                i += digits;
+            }
+            else {
+                out[written++] = escape;
+            }
+            break;
         }
-
-        // Handle multi-character operators (e.g., ==, <=)
-        if (isMultiCharOperator(input, i)) {
-            tokens.push_back(Token(TOK_OPERATOR, input.substr(i, 2)));
-            i += 2;
-            continue;
+        default:
+            // \\, \', \", \? and unknown escapes stand for the character itself
+            out[written++] = escape;
+            break;
         }
+    }
+    return written;
+}
 
-        // Handle single-character operators
-        if (isOperator(current)) {
-            tokens.push_back(Token(TOK_OPERATOR, std::string(1, current)));
+// Check an integer suffix (u, l, ll, z in either case and order, l and z exclusive)
+static bool integerSuffix(std::string_view suffix, uint8_t& bits) {
+    size_t i = 0;
+    while (i < suffix.length()) {
+        char c = suffix[i];
+        if ((c == 'u' || c == 'U') && !(bits & NUM_UNSIGNED)) {
+            bits |= NUM_UNSIGNED;
             i++;
-            continue;
         }
-
-        // Handle punctuation (e.g., ';', '{', '}', '(', ')')
-        if (ispunct(current) && current != '"' && current != '\'') {
-            tokens.push_back(Token(TOK_PUNCTUATION, std::string(1, current)));
-            i++;
-            continue;
+        else if ((c == 'l' || c == 'L') && !(bits & (NUM_LONG | NUM_LONG_LONG | NUM_SIZE))) {
+            // "ll" and "LL" but not "lL"
+            bool twice = i + 1 < suffix.length() && suffix[i + 1] == c;
+            bits |= twice ? NUM_LONG_LONG : NUM_LONG;
+            i += twice ? 2 : 1;
         }
-
-        // Handle string literals
-        if (current == '\"') {
-            std::string strLit;
-            strLit += current;
+        else if ((c == 'z' || c == 'Z') && !(bits & (NUM_LONG | NUM_LONG_LONG | NUM_SIZE))) {
+            bits |= NUM_SIZE;
             i++;
-            while (i < length && input[i] != '\"') {
-                if (input[i] == '\\' && i + 1 < length) {
-                    strLit += input[i++];  // Handle escape sequences in strings
-                }
-                strLit += input[i++];
-            }
-            if (i < length) {
-                strLit += input[i++]; // Add closing quote
-            }
-            tokens.push_back(Token(TOK_STRING, strLit));
-            continue;
         }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
 
-        // Handle character literals (e.g., 'a')
-        if (current == '\'') {
-            std::string charLit;
-            charLit += current;
-            i++;
-            while (i < length && input[i] != '\'') {
-                if (input[i] == '\\' && i + 1 < length) {
-                    charLit += input[i++];  // Handle escape sequences in char literals
-                }
-                charLit += input[i++];
-            }
-            if (i < length) {
-                charLit += input[i++]; // Add closing quote
+// Parse a numeric literal. Separators are dropped into a scratch buffer,
+// the digits are located by hand (prefix, fraction, exponent), and
+// std::from_chars converts them; whatever follows the digits is the suffix.
+bool parseNumber(std::string_view text, NumericValue& value) {
+    value = NumericValue{};
+
+    char stack[64];
+    std::string heap;
+    char* digits = stack;
+    if (text.length() >= sizeof(stack)) {
+        heap.resize(text.length() + 1);
+        digits = &heap[0];
+    }
+    int base = 10;
+    size_t prefix = 0;
+    if (text.length() >= 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        base = 16;
+        prefix = 2;
+    }
+    else if (text.length() >= 2 && text[0] == '0' && (text[1] == 'b' || text[1] == 'B')) {
+        base = 2;
+        prefix = 2;
+    }
+    auto isDigit = [base](char c) {
+        return base == 16 ? hexValue(c) >= 0 : (c >= '0' && c <= '9');
+    };
+
+    // A digit separator must sit between two digits: not doubled, leading, trailing or next to a '.'
+    size_t length = 0;
+    for (size_t i = 0; i < text.length(); i++) {
+        if (text[i] != '\'') {
+            digits[length++] = text[i];
+        }
+        else if (i <= prefix || i + 1 >= text.length() || !isDigit(text[i - 1]) || !isDigit(text[i + 1])) {
+            return false;
+        }
+    }
+    const char* p = digits + prefix;
+    const char* end = digits + length;
+
+    // Find where the digits stop and whether a fraction or exponent makes it floating
+    const char* q = p;
+    size_t mantissa = 0;
+    while (q < end && isDigit(*q)) {
+        q++;
+        mantissa++;
+    }
+    bool fraction = false;
+    if (base != 2 && q < end && *q == '.') {
+        fraction = true;
+        q++;
+        while (q < end && isDigit(*q)) {
+            q++;
+            mantissa++;
+        }
+    }
+    bool exponent = false;
+    if (base != 2 && q < end && (*q | 0x20) == (base == 16 ? 'p' : 'e')) {
+        const char* e = q + 1;
+        if (e < end && (*e == '+' || *e == '-')) {
+            e++;
+        }
+        if (e < end && *e >= '0' && *e <= '9') {
+            exponent = true;
+            q = e;
+            while (q < end && *q >= '0' && *q <= '9') {
+                q++;
             }
-            tokens.push_back(Token(TOK_CHAR, charLit));
-            continue;
         }
+    }
+    bool floating = fraction || exponent;
+    if (mantissa == 0 || (base == 16 && fraction && !exponent)) {
+        return false;  // No digits, or a hex float without its binary exponent
+    }
+
+    std::string_view suffix(q, end - q);
+    bool user = !suffix.empty() && suffix[0] == '_';
+    if (user) {
+        value.suffix |= NUM_USER;
+    }
 
-        // Handle member access (e.g., ., ->)
-        if (current == '.' || current == '-') {
-            if (current == '-' && i + 1 < length && input[i + 1] == '>') {
-                tokens.push_back(Token(TOK_PUNCTUATION, "->"));
-                i += 2;
+    if (floating) {
+        if (!user) {
+            if (suffix == "f" || suffix == "F") {
+                value.suffix |= NUM_FLOAT;
             }
-            else {
-                tokens.push_back(Token(TOK_PUNCTUATION, "."));
-                i++;
+            else if (suffix == "l" || suffix == "L") {
+                value.suffix |= NUM_LONG;
+            }
+            else if (!suffix.empty()) {
+                return false;
             }
-            continue;
         }
+        std::chars_format format = base == 16 ? std::chars_format::hex : std::chars_format::general;
+        std::from_chars_result result;
+        if (value.suffix & NUM_FLOAT) {
+            float single = 0;
+            result = std::from_chars(p, q, single, format);
+            value.floating = single;
+        }
+        else {
+            result = std::from_chars(p, q, value.floating, format);
+        }
+        if (result.ptr != q) {
+            return false;
+        }
+        if (result.ec == std::errc::result_out_of_range) {
+            // from_chars leaves the value alone; strtod gives the infinity or zero it rounds to
+            value.overflow = true;
+            digits[q - digits] = '\0';
+            value.floating = (value.suffix & NUM_FLOAT) ? std::strtof(digits, nullptr) : std::strtod(digits, nullptr);
+        }
+        value.kind = NUM_FLOATING;
+        return true;
+    }
 
-        
-
-        // Handle unknown characters
-        tokens.push_back(Token(TOK_UNKNOWN, std::string(1, current)));
-        i++;
+    // A leading 0 makes an integer octal ("0" itself included)
+    if (base == 10 && *p == '0') {
+        base = 8;
+    }
+    if (!user && !integerSuffix(suffix, value.suffix)) {
+        return false;
     }
+    std::from_chars_result result = std::from_chars(p, q, value.integer, base);
+    if (result.ptr != q) {
+        return false;  // An 8 or 9 in an octal literal
+    }
+    if (result.ec == std::errc::result_out_of_range) {
+        value.overflow = true;
+        value.integer = UINT64_MAX;
+    }
+    value.kind = NUM_INTEGER;
+    return true;
+}
 
-    return tokens;
+// Tokenize input string into owning tokens (compatibility layer over the span lexer)
+std::vector<Token> tokenize(const std::string& input) {
+    return tokenize<FullPolicy>(input);
 }
 
 // Map keyword strings to TokenType
-TokenType wordToTokenType(const std::string& word) {
-    if (word == "int") return TOK_INT;
-    if (word == "float") return TOK_FLOAT;
-    if (word == "double") return TOK_DOUBLE;
-    if (word == "bool") return TOK_BOOL;
-    if (word == "return") return TOK_RETURN;
-    if (word == "void") return TOK_VOID;
-    if (word == "namespace") return TOK_NAMESPACE;
-    if (word == "enum") return TOK_ENUM;
-    if (word == "if") return TOK_IF;
-    if (word == "else") return TOK_ELSE;
-    if (word == "for") return TOK_FOR;
-    if (word == "while") return TOK_WHILE;
-    if (word == "do") return TOK_DO;
-    if (word == "switch") return TOK_SWITCH;
-    if (word == "case") return TOK_CASE;
-    if (word == "break") return TOK_BREAK;
-    if (word == "continue") return TOK_CONTINUE;
-    if (word == "default") return TOK_DEFAULT;
-    if (word == "static") return TOK_STATIC;
-    if (word == "const") return TOK_CONST;
-    if (word == "class") return TOK_CLASS;
-    if (word == "struct") return TOK_STRUCT;
-    if (word == "public") return TOK_PUBLIC;
-    if (word == "private") return TOK_PRIVATE;
-    if (word == "protected") return TOK_PROTECTED;
-    if (word == "virtual") return TOK_VIRTUAL;
-    if (word == "override") return TOK_OVERRIDE;
-    if (word == "new") return TOK_NEW;
-    if (word == "delete") return TOK_DELETE;
-    if (word == "try") return TOK_TRY;
-    if (word == "catch") return TOK_CATCH;
-    if (word == "throw") return TOK_THROW;
-    if (word == "using") return TOK_USING;
-    if (word == "asm") return TOK_ASM;
-    if (word == "auto") return TOK_AUTO;
-    if (word == "char") return TOK_CHAR;
-    if (word == "extern") return TOK_EXTERN;
-    if (word == "friend") return TOK_FRIEND;
-    if (word == "inline") return TOK_INLINE;
-    if (word == "long") return TOK_LONG;
-    if (word == "register") return TOK_REGISTER;
-    if (word == "signed") return TOK_SIGNED;
-    if (word == "short") return TOK_SHORT;
-    if (word == "this") return TOK_THIS;
-    if (word == "typedef") return TOK_TYPEDEF;
-    if (word == "union") return TOK_UNION;
-    if (word == "unsigned") return TOK_UNSIGNED;
-    if (word == "volatile") return TOK_VOLATILE;
+TokenType wordToTokenType(std::string_view word) {
+    TokenType type = classifyWord(word);
 
     // If not a keyword, return generic keyword token
-    return TOK_KEYWORD;
+    return type == TOK_IDENTIFIER ? TOK_KEYWORD : type;
 }
-
-
@@ -0,0 +1,82 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <string_view>
+#include "tokenizer.h"
+
+// Bump allocator. Allocation is a pointer increment inside the current block;
+// nothing is freed individually. reset() rewinds the arena for reuse and the
+// destructor returns every block at once, so tearing down any number of
+// objects placed in the arena is O(blocks), not O(objects).
+class Arena {
+public:
+    explicit Arena(size_t blockSize = 64 * 1024);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Return size bytes aligned to align (a power of two); never returns null
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    // Return uninitialized storage for count objects of a trivially destructible type
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    // Copy text into the arena
+    std::string_view copy(std::string_view text);
+
+    // Make sure the next size bytes can be served from a single block
+    void reserve(size_t size);
+
+    // Drop everything allocated so far, keeping the largest block for reuse
+    void reset();
+
+    size_t used() const { return used_; }          // Bytes handed out since the last reset
+    size_t capacity() const { return capacity_; }  // Bytes held in blocks
+
+private:
+    struct Block {
+        Block* next;  // Previously filled block
+        size_t size;  // Usable bytes after the header
+    };
+
+    void grow(size_t minimum);
+
+    Block* head_ = nullptr;  // Current block
+    char* cursor_ = nullptr; // Next free byte in head_
+    char* limit_ = nullptr;  // End of head_
+    size_t blockSize_;
+    size_t used_ = 0;
+    size_t capacity_ = 0;
+};
+
+// Structure to represent a token whose text lives in an Arena
+struct ArenaToken {
+    TokenType type;          // Type of token
+    uint32_t offset;         // Byte offset of the token in the source
+    std::string_view text;   // The token text, inside the arena copy of the source
+    std::string_view value;  // Unescaped contents for string and char literals; text otherwise
+};
+
+// Structure to represent the token array of tokenizeArena
+struct ArenaTokens {
+    const ArenaToken* tokens = nullptr;
+    size_t count = 0;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const ArenaToken& operator[](size_t i) const { return tokens[i]; }
+    const ArenaToken* begin() const { return tokens; }
+    const ArenaToken* end() const { return tokens + count; }
+};
+
+// Function to tokenize input with the source copy, unescaped literal contents
+// and the token array all placed in arena. The result stays valid until the
+// arena is reset or destroyed, independently of input.
+ArenaTokens tokenizeArena(std::string_view input, Arena& arena); // Function declaration
+
+#endif // ARENA_H
@@ -0,0 +1,41 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <string>
+#include <vector>
+#include "mappedfile.h"
+
+// Structure holding the outcome for one file of a batch
+struct FileResult {
+    std::string path;       // Path as given to tokenizeBatch
+    TokenizedFile file;     // Mapping and tokens; empty when error is set
+    std::string error;      // Empty on success
+    double seconds = 0;     // Time spent mapping and lexing this file
+    unsigned worker = 0;    // Index of the worker that processed it
+};
+
+// Structure holding what one worker of a batch did
+struct WorkerStats {
+    size_t files = 0;       // Files processed
+    size_t bytes = 0;       // Source bytes lexed
+    size_t tokens = 0;      // Tokens produced
+    size_t steals = 0;      // Files taken from another worker's queue
+    double busySeconds = 0; // Time spent inside tokenizeFile
+};
+
+// Structure holding the results of tokenizeBatch, one entry per input path in order
+struct BatchResult {
+    std::vector<FileResult> files;
+    std::vector<WorkerStats> workers;
+    size_t failed = 0;       // Files whose error is set
+    double wallSeconds = 0;  // End-to-end time of the batch
+};
+
+// Function to tokenize many files on a work-stealing pool.
+// Files are dealt to per-worker queues largest first so the big ones start
+// early. Idle workers steal the smallest remaining file from a busy peer.
+// Each worker writes only its own result slots and statistics, so nothing is
+// shared except the per-queue locks taken when a queue is popped.
+BatchResult tokenizeBatch(const std::vector<std::string>& paths, unsigned threads = 0); // Function declaration
+
+#endif // BATCH_H
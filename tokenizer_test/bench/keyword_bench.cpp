@@ -0,0 +1,136 @@
+// Microbenchmark: classifyWord() against the previous unordered_set + if-chain keyword lookup.
+// Build: the keyword_bench CMake target (cmake --build <dir> --target keyword_bench)
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "tokenizer.h"
+
+// Previous lookup: hash the std::string into a set, then walk the compare chain
+static const std::unordered_set<std::string> legacyKeywords = {
+    "int", "float", "double", "bool", "return", "void", "namespace", "enum",
+    "if", "else", "for", "while", "do", "switch", "case", "break", "continue",
+    "default", "static", "const", "class", "struct", "public", "private", "protected",
+    "virtual", "override", "new", "delete", "try", "catch", "throw", "using", "asm",
+    "auto", "char", "extern", "friend", "inline", "long", "register", "signed", "short",
+    "this", "typedef", "union", "unsigned", "volatile", "template"
+};
+
+static TokenType legacyWordToTokenType(const std::string& word) {
+    if (word == "int") return TOK_INT;
+    if (word == "float") return TOK_FLOAT;
+    if (word == "double") return TOK_DOUBLE;
+    if (word == "bool") return TOK_BOOL;
+    if (word == "return") return TOK_RETURN;
+    if (word == "void") return TOK_VOID;
+    if (word == "namespace") return TOK_NAMESPACE;
+    if (word == "enum") return TOK_ENUM;
+    if (word == "if") return TOK_IF;
+    if (word == "else") return TOK_ELSE;
+    if (word == "for") return TOK_FOR;
+    if (word == "while") return TOK_WHILE;
+    if (word == "do") return TOK_DO;
+    if (word == "switch") return TOK_SWITCH;
+    if (word == "case") return TOK_CASE;
+    if (word == "break") return TOK_BREAK;
+    if (word == "continue") return TOK_CONTINUE;
+    if (word == "default") return TOK_DEFAULT;
+    if (word == "static") return TOK_STATIC;
+    if (word == "const") return TOK_CONST;
+    if (word == "class") return TOK_CLASS;
+    if (word == "struct") return TOK_STRUCT;
+    if (word == "public") return TOK_PUBLIC;
+    if (word == "private") return TOK_PRIVATE;
+    if (word == "protected") return TOK_PROTECTED;
+    if (word == "virtual") return TOK_VIRTUAL;
+    if (word == "override") return TOK_OVERRIDE;
+    if (word == "new") return TOK_NEW;
+    if (word == "delete") return TOK_DELETE;
+    if (word == "try") return TOK_TRY;
+    if (word == "catch") return TOK_CATCH;
+    if (word == "throw") return TOK_THROW;
+    if (word == "using") return TOK_USING;
+    if (word == "asm") return TOK_ASM;
+    if (word == "auto") return TOK_AUTO;
+    if (word == "char") return TOK_CHAR;
+    if (word == "extern") return TOK_EXTERN;
+    if (word == "friend") return TOK_FRIEND;
+    if (word == "inline") return TOK_INLINE;
+    if (word == "long") return TOK_LONG;
+    if (word == "register") return TOK_REGISTER;
+    if (word == "signed") return TOK_SIGNED;
+    if (word == "short") return TOK_SHORT;
+    if (word == "this") return TOK_THIS;
+    if (word == "typedef") return TOK_TYPEDEF;
+    if (word == "union") return TOK_UNION;
+    if (word == "unsigned") return TOK_UNSIGNED;
+    if (word == "volatile") return TOK_VOLATILE;
+    return TOK_KEYWORD;
+}
+
+// What tokenize() used to do for every identifier-shaped word
+static TokenType legacyClassify(const std::string& word) {
+    if (legacyKeywords.find(word) != legacyKeywords.end()) {
+        return legacyWordToTokenType(word);
+    }
+    return TOK_IDENTIFIER;
+}
+
+// Build a word list with roughly the keyword/identifier mix of ordinary C++ code
+static std::vector<std::string> makeWords(size_t count) {
+    static const char* samples[] = {
+        "int", "return", "const", "if", "for", "auto", "unsigned", "static", "void", "else",
+        "i", "x", "value", "size", "tokens", "input", "length", "std", "vector", "string",
+        "buffer_", "count", "result", "TokenType", "push_back", "emplace_back", "begin", "end",
+        "nullptr", "index", "data", "constexpr", "noexcept", "m_state", "kMaxDepth", "it"
+    };
+    const size_t sampleCount = sizeof(samples) / sizeof(samples[0]);
+
+    std::vector<std::string> words;
+    words.reserve(count);
+    uint32_t state = 12345;
+    for (size_t k = 0; k < count; k++) {
+        state = state * 1664525u + 1013904223u;
+        words.push_back(samples[(state >> 8) % sampleCount]);
+    }
+    return words;
+}
+
+template <typename Fn>
+static double timeNsPerWord(const std::vector<std::string>& words, int rounds, Fn classify, uint64_t& checksum) {
+    auto begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (const std::string& word : words) {
+            checksum += static_cast<uint64_t>(classify(word));
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - begin).count();
+    return ns / (static_cast<double>(words.size()) * rounds);
+}
+
+int main() {
+    const size_t wordCount = 1 << 16;
+    const int rounds = 200;
+    std::vector<std::string> words = makeWords(wordCount);
+
+    // Both lookups must agree before timing means anything
+    for (const std::string& word : words) {
+        if (legacyClassify(word) != classifyWord(word)) {
+            std::printf("mismatch for '%s'\n", word.c_str());
+            return 1;
+        }
+    }
+
+    uint64_t legacySum = 0;
+    uint64_t perfectSum = 0;
+    double legacyNs = timeNsPerWord(words, rounds, [](const std::string& w) { return legacyClassify(w); }, legacySum);
+    double perfectNs = timeNsPerWord(words, rounds, [](const std::string& w) { return classifyWord(w); }, perfectSum);
+
+    std::printf("unordered_set + if-chain : %6.2f ns/word\n", legacyNs);
+    std::printf("perfect-hash classifyWord: %6.2f ns/word\n", perfectNs);
+    std::printf("speedup                  : %6.2fx\n", legacyNs / perfectNs);
+    return legacySum == perfectSum ? 0 : 1;
+}
@@ -0,0 +1,368 @@
+// Throughput benchmark for tokenize() over generated and real C++ corpora.
+// Reports MB/s, tokens/s and heap allocations per token for each case, and
+// the peak RSS of the whole run (the OS only tracks a process-wide high-water
+// mark, so it cannot be split by case), as a table or as JSON (--json) for
+// tracking regressions between versions.
+// Build: the lexer_bench CMake target (cmake --build <dir> --target lexer_bench)
+// Usage: lexer_bench [--json] [--size MB] [--seconds S] [real C++ files...]
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "tokenizer.h"
+#include "lexer.h"
+#include "scan.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <malloc.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Every heap allocation in the process goes through here so it can be counted:
+// the plain, nothrow and over-aligned forms of operator new are replaced, and
+// the array and nothrow-delete forms forward to these by default
+static std::atomic<uint64_t> allocationCount(0);
+
+static void* allocate(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+static void* allocateAligned(size_t size, std::align_val_t alignment) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+#ifdef _WIN32
+    return _aligned_malloc(size ? size : 1, align);
+#else
+    // aligned_alloc wants a size that is a multiple of the alignment
+    return std::aligned_alloc(align, size ? (size + align - 1) / align * align : align);
+#endif
+}
+
+static void freeAligned(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(size_t size) {
+    if (void* p = allocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    if (void* p = allocateAligned(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    freeAligned(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    freeAligned(p);
+}
+
+// Peak resident set size of the process so far, in bytes: a high-water mark
+// that only ever rises, so it describes the run, not the case that just ran
+static uint64_t peakRss() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<uint64_t>(usage.ru_maxrss);         // Bytes on macOS
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;  // Kilobytes on Linux
+#endif
+#endif
+}
+
+// Small deterministic generator so corpora are identical from run to run
+struct Random {
+    uint32_t state;
+    explicit Random(uint32_t seed) : state(seed) {}
+    uint32_t next() {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+    const char* pick(const char* const* items, size_t count) { return items[next() % count]; }
+};
+
+static const char* const names[] = {
+    "i", "x", "value", "size", "tokens", "input", "length", "buffer_", "count", "result",
+    "TokenType", "push_back", "begin", "end", "index", "data", "m_state", "kMaxDepth", "it",
+    "int", "return", "const", "if", "for", "auto", "unsigned", "static", "void", "else"
+};
+static const size_t nameCount = sizeof(names) / sizeof(names[0]);
+
+static const char* const operators[] = {
+    "+", "-", "*", "/", "%", "=", "==", "!=", "<", ">", "<=", ">=", "&&", "||", "<<", ">>",
+    "+=", "-=", "++", "--", "&", "|", "^", "!", "~", "::", "(", ")", "[", "]", ";", ","
+};
+static const size_t operatorCount = sizeof(operators) / sizeof(operators[0]);
+
+// Long runs of names separated by single spaces and the odd call or semicolon
+static std::string identifierHeavy(size_t bytes) {
+    Random random(1);
+    std::string out;
+    while (out.size() < bytes) {
+        for (int k = 0; k < 8; k++) {
+            out += random.pick(names, nameCount);
+            out += ' ';
+        }
+        out += (random.next() & 1) ? "(x);\n" : ";\n";
+    }
+    return out;
+}
+
+// Mostly line and block comments with a little code between them
+static std::string commentHeavy(size_t bytes) {
+    Random random(2);
+    std::string out;
+    while (out.size() < bytes) {
+        out += "// ";
+        for (int k = 0; k < 10; k++) {
+            out += random.pick(names, nameCount);
+            out += ' ';
+        }
+        out += "\n/* ";
+        for (int k = 0; k < 30; k++) {
+            out += random.pick(names, nameCount);
+            out += (k % 10 == 9) ? "\n * " : " ";
+        }
+        out += "*/\nint x;\n";
+    }
+    return out;
+}
+
+// String and character literals, some with escapes
+static std::string stringHeavy(size_t bytes) {
+    Random random(3);
+    std::string out;
+    while (out.size() < bytes) {
+        out += "s = \"";
+        for (int k = 0; k < 6; k++) {
+            out += random.pick(names, nameCount);
+            out += (random.next() % 4 == 0) ? "\\n" : " ";
+        }
+        out += "\\\"quoted\\\"\"; c = '";
+        out += (random.next() & 1) ? "\\t" : "a";
+        out += "';\n";
+    }
+    return out;
+}
+
+// Operators and punctuation with one-letter operands and no spaces
+static std::string operatorDense(size_t bytes) {
+    Random random(4);
+    std::string out;
+    while (out.size() < bytes) {
+        for (int k = 0; k < 16; k++) {
+            out += static_cast<char>('a' + random.next() % 26);
+            out += random.pick(operators, operatorCount);
+        }
+        out += "1;\n";
+    }
+    return out;
+}
+
+// Block comments whose bodies are full of further comment openers, as left
+// behind by commenting out code that was already commented out
+static std::string nestedComments(size_t bytes) {
+    Random random(5);
+    std::string out;
+    while (out.size() < bytes) {
+        int depth = 1 + random.next() % 32;
+        for (int k = 0; k < depth; k++) {
+            out += "/* ";
+            out += random.pick(names, nameCount);
+            out += ' ';
+        }
+        out += "* / ** // */\n";
+        out += "x = y;\n";
+    }
+    return out;
+}
+
+// Concatenation of the given files
+static std::string readFiles(const std::vector<std::string>& paths) {
+    std::string out;
+    for (const std::string& path : paths) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::fprintf(stderr, "cannot read %s\n", path.c_str());
+            std::exit(1);
+        }
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        out += contents.str();
+        out += '\n';
+    }
+    return out;
+}
+
+// Structure holding the measurements for one corpus and API
+struct Result {
+    std::string corpus;
+    std::string api;
+    size_t bytes = 0;
+    size_t tokens = 0;
+    int iterations = 0;
+    double mbPerSecond = 0;
+    double tokensPerSecond = 0;
+    double allocationsPerToken = 0;
+};
+
+// Run lex (which returns the token count) until at least seconds have passed
+template <typename Fn>
+static Result measure(const std::string& corpus, const char* api, const std::string& input, double seconds, Fn lex) {
+    Result result;
+    result.corpus = corpus;
+    result.api = api;
+    result.bytes = input.size();
+
+    // One untimed run warms the caches and sizes any reused buffers
+    result.tokens = lex(input);
+
+    uint64_t allocations = allocationCount.load(std::memory_order_relaxed);
+    auto begin = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    do {
+        lex(input);
+        result.iterations++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    } while (elapsed < seconds);
+    allocations = allocationCount.load(std::memory_order_relaxed) - allocations;
+
+    double runs = result.iterations;
+    result.mbPerSecond = input.size() * runs / elapsed / 1e6;
+    result.tokensPerSecond = result.tokens * runs / elapsed;
+    result.allocationsPerToken = result.tokens ? allocations / (runs * result.tokens) : 0;
+    return result;
+}
+
+static void printTable(const std::vector<Result>& results, uint64_t peakRssBytes) {
+    std::printf("%-18s %-8s %10s %10s %12s %10s\n",
+        "corpus", "api", "MB", "MB/s", "Mtokens/s", "alloc/tok");
+    for (const Result& r : results) {
+        std::printf("%-18s %-8s %10.2f %10.1f %12.2f %10.3f\n",
+            r.corpus.c_str(), r.api.c_str(), r.bytes / 1e6, r.mbPerSecond,
+            r.tokensPerSecond / 1e6, r.allocationsPerToken);
+    }
+    std::printf("peak RSS: %.1fM\n", peakRssBytes / 1048576.0);
+}
+
+static void printJson(const std::vector<Result>& results, uint64_t peakRssBytes) {
+    std::printf("{\n  \"benchmark\": \"lexer\",\n  \"scan_level\": \"%s\",\n  \"peak_rss_bytes\": %llu,\n"
+        "  \"results\": [\n", scanLevelName(activeScanLevel()), static_cast<unsigned long long>(peakRssBytes));
+    for (size_t k = 0; k < results.size(); k++) {
+        const Result& r = results[k];
+        std::printf("    {\"corpus\": \"%s\", \"api\": \"%s\", \"bytes\": %zu, \"tokens\": %zu, "
+            "\"iterations\": %d, \"mb_per_s\": %.3f, \"tokens_per_s\": %.0f, "
+            "\"allocations_per_token\": %.4f}%s\n",
+            r.corpus.c_str(), r.api.c_str(), r.bytes, r.tokens, r.iterations, r.mbPerSecond,
+            r.tokensPerSecond, r.allocationsPerToken, k + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+    bool json = false;
+    size_t megabytes = 8;
+    double seconds = 1.0;
+    std::vector<std::string> realFiles;
+
+    for (int arg = 1; arg < argc; arg++) {
+        if (std::strcmp(argv[arg], "--json") == 0) {
+            json = true;
+        }
+        else if (std::strcmp(argv[arg], "--size") == 0 && arg + 1 < argc) {
+            megabytes = std::strtoul(argv[++arg], nullptr, 10);
+        }
+        else if (std::strcmp(argv[arg], "--seconds") == 0 && arg + 1 < argc) {
+            seconds = std::strtod(argv[++arg], nullptr);
+        }
+        else {
+            realFiles.push_back(argv[arg]);
+        }
+    }
+
+    size_t bytes = megabytes * 1000 * 1000;
+    std::vector<std::pair<std::string, std::string>> corpora = {
+        { "identifiers", identifierHeavy(bytes) },
+        { "comments", commentHeavy(bytes) },
+        { "strings", stringHeavy(bytes) },
+        { "operators", operatorDense(bytes) },
+        { "nested-comments", nestedComments(bytes) },
+    };
+    if (!realFiles.empty()) {
+        corpora.emplace_back("real", readFiles(realFiles));
+    }
+
+    std::vector<Result> results;
+    std::vector<TokenSpan> spans;
+    for (const auto& corpus : corpora) {
+        // Span API into a reused vector: the allocation-free path
+        results.push_back(measure(corpus.first, "spans", corpus.second, seconds, [&](const std::string& input) {
+            spans.clear();
+            tokenize(std::string_view(input), spans);
+            return spans.size();
+        }));
+        // CodePolicy spans: comments and directives skipped without forming tokens
+        results.push_back(measure(corpus.first, "code", corpus.second, seconds, [&](const std::string& input) {
+            spans.clear();
+            tokenize<CodePolicy>(std::string_view(input), spans);
+            return spans.size();
+        }));
+        // Owning API: one std::string per token
+        results.push_back(measure(corpus.first, "owning", corpus.second, seconds, [](const std::string& input) {
+            return tokenize(input).size();
+        }));
+    }
+
+    if (json) {
+        printJson(results, peakRss());
+    }
+    else {
+        printTable(results, peakRss());
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+#ifndef DEPENDENCYSCAN_H
+#define DEPENDENCYSCAN_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "mappedfile.h"
+#include "tokenizer.h"
+
+// Include scanning for build graphs. Instead of lexing every token, the
+// scanner jumps with findDirectiveOrLiteral() from one '#', '/' or quote to
+// the next and lets the Lexer consume just that token (for a quote, the word
+// before it too, since 1'000 has a digit separator). Comments, string and
+// character literals are skipped exactly as tokenize() skips them, so an
+// #include inside any of them is never reported, and the result always
+// equals the directive tokens of tokenize() filtered down to includes and
+// conditionals.
+
+// Structure describing one directive that matters for dependencies
+struct Dependency {
+    TokenType type;         // TOK_PP_INCLUDE or a conditional (TOK_PP_IF ... TOK_PP_ENDIF)
+    uint32_t offset;        // Byte offset of the '#'
+    uint32_t length;        // Length of the whole directive
+    uint32_t depth;         // Number of conditionals enclosing it; #elif, #else and #endif sit at their #if's depth
+    bool angled;            // Include of a <...> header name
+    std::string_view text;  // Include: the header name, empty if computed. Conditional: the condition, if any.
+};
+
+// Function to append the includes and conditionals of source to out, in source order
+void scanDependencies(std::string_view source, std::vector<Dependency>& out); // Function declaration
+
+// Structure holding the scan of one file; text views point into the mapping
+struct FileDependencies {
+    std::string path;                       // Path as given to scanDependencyFiles
+    MappedFile file;                        // The mapped source; empty when error is set
+    std::vector<Dependency> dependencies;   // What scanDependencies found
+    std::string error;                      // Empty on success
+};
+
+// Function to map and scan many files on a pool of threads (0 = one per core).
+// Results are in the order of paths; workers take the next unscanned file
+// from a shared counter.
+std::vector<FileDependencies> scanDependencyFiles(const std::vector<std::string>& paths, unsigned threads = 0); // Function declaration
+
+#endif // DEPENDENCYSCAN_H
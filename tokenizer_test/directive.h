@@ -0,0 +1,38 @@
+#ifndef DIRECTIVE_H
+#define DIRECTIVE_H
+
+#include <string_view>
+#include <vector>
+#include "tokenizer.h"
+
+// The lexer emits each preprocessor directive as a single token covering the
+// whole logical line: backslash-newline continuations and block comments do
+// not end it, while quotes only run to the end of their physical line. As in
+// the tokenizer it replaced, any '#' outside a literal or comment starts one,
+// not just the first on a line: "x # y" is x and then the directive "# y".
+// The token type names the directive (TOK_PP_INCLUDE, TOK_PP_DEFINE, ...). The
+// functions here take a directive token apart on demand, without allocating
+// anything but the sub-token output.
+
+// Function to map a directive name ("include", "ifdef", ...) to its token type, TOK_HEADER if unknown
+TokenType directiveType(std::string_view name); // Function declaration
+
+// Function to get the name of a directive from its token text ("define" for "#  define X 1");
+// empty for the null directive or when no identifier follows the '#'
+std::string_view directiveName(std::string_view directive); // Function declaration
+
+// Function to get the text after the directive name, with leading blanks, comments and continuations skipped
+std::string_view directiveBody(std::string_view directive); // Function declaration
+
+// Function to get the header named by an #include token: path is the text between
+// the delimiters and angled tells <...> from "...". Returns false for computed
+// includes (#include MACRO) and unterminated names.
+bool includePath(std::string_view directive, std::string_view& path, bool& angled); // Function declaration
+
+// Function to lex a directive token into sub-tokens with offsets in source:
+// '#' (TOK_PUNCTUATION), the name (TOK_IDENTIFIER), then the body. In the body
+// '#' and '##' are TOK_OPERATOR, continuations are skipped, and an #include
+// header name is one TOK_STRING including its delimiters.
+void lexDirective(std::string_view source, const TokenSpan& directive, std::vector<TokenSpan>& out); // Function declaration
+
+#endif // DIRECTIVE_H
@@ -0,0 +1,72 @@
+#ifndef INCREMENTALLEXER_H
+#define INCREMENTALLEXER_H
+
+#include <string_view>
+#include <vector>
+#include "tokenizer.h"
+
+// Structure describing one edit: removed bytes starting at offset (in the
+// text before the edit) were replaced by inserted bytes
+struct TextEdit {
+    size_t offset;    // Start of the replaced range
+    size_t removed;   // Bytes removed at offset
+    size_t inserted;  // Bytes inserted in their place
+};
+
+// Structure describing which tokens an edit replaced
+struct RelexResult {
+    size_t first;     // Index of the first token that changed
+    size_t removed;   // Old tokens dropped from first on
+    size_t inserted;  // New tokens inserted at first
+};
+
+// Token list that follows edits to its source without re-lexing the whole
+// buffer. An edit re-lexes from the end of the last token it cannot affect
+// until the new tokens land on a token start the old list also had; from
+// there on the old tokens are still right, since the Lexer is context-free at
+// token boundaries. The tokens live in a gap buffer whose gap sits at the
+// last edit, and tokens after the gap store their distance from the end of
+// the source instead of their offset. Edits therefore never shift the rest
+// of the list, and successive edits near each other cost time proportional
+// to the text re-lexed, not to the file size.
+class IncrementalLexer {
+public:
+    IncrementalLexer() = default;
+
+    // Lexes source from scratch
+    explicit IncrementalLexer(std::string_view source);
+
+    // Adopts tokens previously lexed from a source of sourceLength bytes
+    IncrementalLexer(std::vector<TokenSpan> tokens, size_t sourceLength);
+
+    // Update the tokens for an edit. source is the whole text after the edit;
+    // throws std::out_of_range if the edit does not fit the previous text.
+    RelexResult edit(std::string_view source, const TextEdit& change);
+
+    size_t size() const { return tokens_.size() - (gapEnd_ - gapBegin_); }
+    bool empty() const { return size() == 0; }
+    size_t sourceLength() const { return length_; }
+
+    // Token i with its offset in the current source
+    TokenSpan operator[](size_t i) const {
+        if (i < gapBegin_) {
+            return tokens_[i];
+        }
+        const TokenSpan& tail = tokens_[i + (gapEnd_ - gapBegin_)];
+        return TokenSpan{ tail.type, static_cast<uint32_t>(length_ - tail.offset), tail.length };
+    }
+
+    // Replace out with all tokens, offsets resolved
+    void copyTo(std::vector<TokenSpan>& out) const;
+
+private:
+    void moveGap(size_t index);
+    void reserveGap(size_t count);
+
+    std::vector<TokenSpan> tokens_;  // [0, gapBegin_) absolute; [gapEnd_, end) end-relative
+    size_t gapBegin_ = 0;
+    size_t gapEnd_ = 0;
+    size_t length_ = 0;              // Length of the current source
+};
+
+#endif // INCREMENTALLEXER_H
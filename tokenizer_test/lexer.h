@@ -0,0 +1,123 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <string_view>
+#include <type_traits> // For std::conditional_t
+#include <vector>
+#include "lexerstats.h"
+#include "tokenizer.h"
+
+// Version of the token boundaries and types the Lexer produces. Bump it with
+// any change to lexing so that persisted token streams are invalidated.
+constexpr uint32_t LEXER_VERSION = 5;
+
+// Compile-time lexing options. Every combination is its own lexing loop, so
+// a dropped kind costs nothing per token: its branch skips the text and goes
+// on to the next lexeme without ever forming a token. Likewise the counters
+// and timestamps of CollectStats exist only in the instrumented loops.
+template <bool KeepComments, bool KeepDirectives, bool CollectStats = false>
+struct LexPolicy {
+    static constexpr bool keepComments = KeepComments;      // Emit TOK_COMMENT tokens
+    static constexpr bool keepDirectives = KeepDirectives;  // Emit TOK_PP_* and TOK_HEADER tokens
+    static constexpr bool collectStats = CollectStats;      // Fill LexerStats (see lexerstats.h)
+};
+
+using FullPolicy = LexPolicy<true, true>;          // Every token; what Lexer and tokenize() produce
+using CodePolicy = LexPolicy<false, false>;        // What a parser consumes: no comments, no directives
+using StatsPolicy = LexPolicy<true, true, true>;   // FullPolicy with instrumentation
+
+// Pull-based lexer over a caller-owned source buffer. Tokens are produced one
+// at a time by next(), so a consumer can run in lockstep without the whole
+// token vector ever existing. At the end of input next() keeps returning a
+// zero-length TOK_EOF token at offset source.length(). All eight LexPolicy
+// combinations are instantiated in Lexer.cpp.
+template <typename Policy>
+class BasicLexer {
+public:
+    // Lexes source starting at byte offset position (a token boundary)
+    explicit BasicLexer(std::string_view source, size_t position = 0);
+
+    // Consume and return the next token
+    TokenSpan next() {
+        if (head_ < lookahead_.size()) {
+            TokenSpan token = lookahead_[head_++];
+            if (head_ == lookahead_.size()) {
+                lookahead_.clear();
+                head_ = 0;
+            }
+            return token;
+        }
+        return lex();
+    }
+
+    // Return the k-th upcoming token (0 = the one next() returns) without consuming it.
+    // The reference is valid until the next call to next() or peek().
+    const TokenSpan& peek(size_t k = 0);
+
+    // Consume all remaining tokens, appending them (without TOK_EOF) to out
+    void drain(std::vector<TokenSpan>& out);
+
+    // Byte offset just past the last token lexed, including tokens buffered by peek()
+    size_t position() const { return cursor_; }
+
+    std::string_view source() const { return source_; }
+
+    // Counts gathered so far; only instrumented policies have them
+    template <typename P = Policy, typename = std::enable_if_t<P::collectStats>>
+    const LexerStats& stats() const { return stats_; }
+
+private:
+    // Lex one token at the cursor and advance past it
+    TokenSpan lex();
+
+    std::string_view source_;
+    size_t cursor_ = 0;                  // Where lexing resumes
+    std::vector<TokenSpan> lookahead_;   // Tokens lexed by peek() but not yet consumed
+    size_t head_ = 0;                    // First unconsumed entry of lookahead_
+
+    // Empty unless the policy collects statistics
+    struct NoStats {};
+    std::conditional_t<Policy::collectStats, LexerStats, NoStats> stats_;
+};
+
+extern template class BasicLexer<LexPolicy<true, true>>;
+extern template class BasicLexer<LexPolicy<true, false>>;
+extern template class BasicLexer<LexPolicy<false, true>>;
+extern template class BasicLexer<LexPolicy<false, false>>;
+extern template class BasicLexer<LexPolicy<true, true, true>>;
+extern template class BasicLexer<LexPolicy<true, false, true>>;
+extern template class BasicLexer<LexPolicy<false, true, true>>;
+extern template class BasicLexer<LexPolicy<false, false, true>>;
+
+using Lexer = BasicLexer<FullPolicy>;
+
+// Function to tokenize input into spans under a policy, e.g. tokenize<CodePolicy>(source, spans)
+template <typename Policy>
+void tokenize(std::string_view input, std::vector<TokenSpan>& tokens) {
+    BasicLexer<Policy> lexer(input);
+    lexer.drain(tokens);
+}
+
+// Function to tokenize input into owning tokens under a policy; dropped kinds never get a string
+template <typename Policy>
+std::vector<Token> tokenize(const std::string& input) {
+    std::vector<TokenSpan> spans;
+    tokenize<Policy>(input, spans);
+
+    std::vector<Token> tokens;
+    tokens.reserve(spans.size());
+    for (const TokenSpan& span : spans) {
+        tokens.emplace_back(span.type, std::string(span.text(input)), span.offset);
+    }
+    return tokens;
+}
+
+// Function to match the longest operator or punctuator starting at source[i] ("<<=", "->*", "::", ...).
+// Returns its length and sets type (TOK_OPERATOR, TOK_PUNCTUATION or TOK_SCOPE), or returns 0.
+size_t matchOperator(std::string_view source, size_t i, TokenType& type); // Function declaration
+
+// Function to check whether text is the start of a longer operator or punctuator
+// spelling ("-" of "->", ".." of "..."), so more input could change its munch
+bool operatorCanExtend(std::string_view text); // Function declaration
+
+#endif // LEXER_H
@@ -0,0 +1,73 @@
+#ifndef LEXERSTATS_H
+#define LEXERSTATS_H
+
+#include <cstdint>
+#include <string>
+#include "tokenizer.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LEXERSTATS_RDTSC 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#else
+#include <chrono>
+#endif
+
+// Number of TokenType values, for arrays indexed by type
+constexpr size_t TOKEN_TYPE_COUNT = TOK_PP_LINE + 1;
+
+// Enum to represent the dispatch branches of the lexer loop
+enum LexBranch {
+    LEX_WHITESPACE = 0,  // Runs of blanks and newlines
+    LEX_COMMENT = 1,     // Line and block comments
+    LEX_DIRECTIVE = 2,   // Preprocessor directive lines
+    LEX_IDENTIFIER = 3,  // Words that are not keywords
+    LEX_KEYWORD = 4,     // Words that classifyWord() maps to a keyword
+    LEX_NUMBER = 5,      // Numeric literals
+    LEX_OPERATOR = 6,    // Operators and punctuators
+    LEX_LITERAL = 7,     // String and character literals
+    LEX_OTHER = 8,       // Bytes no other branch takes
+    LEX_BRANCH_COUNT = 9,
+};
+
+// Structure holding what an instrumented lexer (LexPolicy with CollectStats)
+// saw. Tokens a policy drops still count as branch hits but not as tokens.
+// Ticks come from the CPU timestamp counter where there is one.
+struct LexerStats {
+    uint64_t tokens[TOKEN_TYPE_COUNT] = {};       // Tokens emitted, per TokenType
+    uint64_t bytes[TOKEN_TYPE_COUNT] = {};        // Bytes those tokens cover
+    uint64_t branchHits[LEX_BRANCH_COUNT] = {};   // Lexemes taken by each branch
+    uint64_t branchBytes[LEX_BRANCH_COUNT] = {};  // Bytes consumed by each branch
+    uint64_t branchTicks[LEX_BRANCH_COUNT] = {};  // Timestamp ticks spent in each branch
+
+    // Add the counts of another run (e.g. another file or thread)
+    void merge(const LexerStats& other);
+
+    // Total tokens emitted and bytes they cover
+    uint64_t totalTokens() const;
+    uint64_t totalBytes() const;
+};
+
+// Function to read a low-overhead timestamp: rdtsc on x86, steady_clock nanoseconds elsewhere
+inline uint64_t readTimestamp() {
+#ifdef LEXERSTATS_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Function to get how many readTimestamp() ticks make a second (measured once, about 20 ms)
+double timestampFrequency(); // Function declaration
+
+// Function to get the display name of a branch ("comment", "keyword", ...)
+const char* lexBranchName(LexBranch branch); // Function declaration
+
+// Function to format stats as a JSON object: per-type and per-branch counts,
+// average lexeme lengths, and branch time in nanoseconds and as a share
+std::string lexerStatsJson(const LexerStats& stats, int indent = 0); // Function declaration
+
+#endif // LEXERSTATS_H
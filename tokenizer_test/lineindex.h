@@ -0,0 +1,49 @@
+#ifndef LINEINDEX_H
+#define LINEINDEX_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Structure to represent a position in the source, both parts 1-based
+struct SourceLocation {
+    uint32_t line;    // Line number
+    uint32_t column;  // Byte column within the line
+};
+
+// Maps byte offsets to line/column for diagnostics. The lexer never counts
+// lines; the first query sweeps the source for newlines once and records
+// where each line starts, and every query is then a binary search over those
+// starts. Lines end at '\n' only, as // comments do in the lexer: the '\r' of
+// a CRLF is the last byte of its line, and a lone '\r' does not end one. The
+// first query mutates the index, so finish one (or call lineCount()) before
+// sharing an index between threads.
+class LineIndex {
+public:
+    LineIndex() = default;
+
+    // Indexes source, which must outlive the index
+    explicit LineIndex(std::string_view source) : source_(source) {}
+
+    // Switch to a new source, dropping any index already built
+    void reset(std::string_view source);
+
+    // Return the line and column of a byte offset (offsets past the end map to the end)
+    SourceLocation locate(size_t offset) const;
+
+    // Return the number of lines; a trailing newline does not start an extra line
+    size_t lineCount() const;
+
+    // Return the text of a 1-based line without its line terminator
+    std::string_view lineText(uint32_t line) const;
+
+    std::string_view source() const { return source_; }
+
+private:
+    void build() const;
+
+    std::string_view source_;
+    mutable std::vector<uint32_t> starts_;  // Offset of each line start; empty until built
+};
+
+#endif // LINEINDEX_H
@@ -0,0 +1,53 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "tokenizer.h"
+
+// Read-only memory mapping of a whole file. Opening failures throw
+// std::system_error carrying the OS error code. What cannot be mapped, such
+// as a pipe, /dev/stdin, or a procfs file that reports a size of zero, is
+// read into memory instead.
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Unmaps the file; views taken from it become dangling
+    void close();
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(data_, size_); }
+
+private:
+    const char* data_ = "";
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<char> buffer_;  // The contents of a file that was read rather than mapped
+#ifdef _WIN32
+    void* mapping_ = nullptr;  // HANDLE of the file mapping object
+#endif
+};
+
+// Structure holding a mapped source file together with its tokens.
+// The spans point into the mapping, so they are valid as long as this lives.
+struct TokenizedFile {
+    MappedFile file;                 // The mapped source text
+    std::vector<TokenSpan> tokens;   // Tokens lexed straight from the mapping
+
+    std::string_view source() const { return file.view(); }
+};
+
+// Function to map a file read-only and tokenize it without copying the source
+TokenizedFile tokenizeFile(const std::string& path); // Function declaration
+
+#endif // MAPPEDFILE_H
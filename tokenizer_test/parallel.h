@@ -0,0 +1,24 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <string_view>
+#include <vector>
+#include "tokenizer.h"
+
+// Structure to tune tokenizeParallel()
+struct ParallelOptions {
+    unsigned threads = 0;             // Worker count; 0 uses std::thread::hardware_concurrency()
+    size_t minChunkBytes = 256 * 1024; // Inputs are never split into chunks smaller than this
+};
+
+// Function to tokenize one large buffer on several threads.
+// The buffer is split into chunks, each chunk is lexed speculatively from its
+// first byte, and the chunks are stitched together by re-lexing from the true
+// token boundary until it lands on a token start the speculative pass also
+// found. The Lexer is context-free at token boundaries, so from that point on
+// the speculative tokens are exactly the sequential ones, and the result is
+// always identical to tokenize(input, tokens).
+void tokenizeParallel(std::string_view input, std::vector<TokenSpan>& tokens,
+    const ParallelOptions& options = ParallelOptions()); // Function declaration
+
+#endif // PARALLEL_H
@@ -0,0 +1,45 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+// Run-scanning kernels used by the lexer. Each kernel returns the end of a run
+// inside [p, end) and has scalar, SSE2 and AVX2 implementations; the widest one
+// the CPU supports is picked at runtime on first use.
+
+// Instruction set levels the kernels can run at
+enum ScanLevel {
+    SCAN_SCALAR = 0,  // Portable byte-at-a-time loops
+    SCAN_SSE2 = 1,    // 16 bytes per step (x86-64 baseline)
+    SCAN_AVX2 = 2,    // 32 bytes per step
+};
+
+// Function to get the best level the running CPU supports
+ScanLevel bestScanLevel(); // Function declaration
+
+// Function to get the level the kernels currently run at
+ScanLevel activeScanLevel(); // Function declaration
+
+// Function to force a level (e.g. for benchmarks); returns false if the CPU lacks it
+bool setScanLevel(ScanLevel level); // Function declaration
+
+// Function to get the display name of a level ("scalar", "sse2", "avx2")
+const char* scanLevelName(ScanLevel level); // Function declaration
+
+// Returns the first byte that is not ' ', \t, \n, \v, \f or \r, or end
+const char* skipWhitespace(const char* p, const char* end); // Function declaration
+
+// Returns the first byte that is not [A-Za-z0-9_], or end
+const char* skipIdentifier(const char* p, const char* end); // Function declaration
+
+// Returns the first '\n', or end
+const char* findLineEnd(const char* p, const char* end); // Function declaration
+
+// Returns the '*' of the first "*/", or end if the comment is unterminated
+const char* findCommentEnd(const char* p, const char* end); // Function declaration
+
+// Returns the first quote or backslash, or end
+const char* findQuoteOrBackslash(const char* p, const char* end, char quote); // Function declaration
+
+// Returns the first '#', '/', '"' or '\'', or end
+const char* findDirectiveOrLiteral(const char* p, const char* end); // Function declaration
+
+#endif // SCAN_H
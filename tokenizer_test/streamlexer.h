@@ -0,0 +1,125 @@
+#ifndef STREAMLEXER_H
+#define STREAMLEXER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "tokenizer.h"
+
+// Structure to represent a token produced by StreamLexer
+struct StreamToken {
+    TokenType type;         // Type of token
+    uint64_t offset;        // Byte offset from the start of the whole stream
+    std::string_view text;  // Token text; valid until the next feed(), finish() or reset()
+};
+
+// Resumable lexer for input that arrives in arbitrary pieces (pipes, sockets).
+//
+// The lexer restarts cleanly at any token boundary, so the only state carried
+// between chunks is the token still in progress at the end of one: its bytes
+// so far, plus where the scan stopped inside it (in a block comment after a
+// '*', in a literal after a backslash, in the quoted part of a directive, in
+// a pp-number after a digit separator, or in an operator that may still grow).
+// The next chunk resumes that scan at its first byte, so carried bytes are
+// never scanned again and a token spanning many chunks costs time linear in
+// its length. Memory stays bounded by the longest single token.
+class StreamLexer {
+public:
+    // The Lexer never looks further than this many bytes past the end of a
+    // token when deciding where it ends, so tokens ending earlier are final.
+    static constexpr size_t lookahead = 4;
+
+    // Feed the next piece of input and append every token that is now final to out.
+    // Tokens lying wholly inside chunk point into it; the text of a token that
+    // began in an earlier chunk is owned by the lexer.
+    void feed(std::string_view chunk, std::vector<StreamToken>& out);
+
+    // Signal end of input and append the remaining tokens to out
+    void finish(std::vector<StreamToken>& out);
+
+    // Forget all state and start a new stream
+    void reset();
+
+    uint64_t consumed() const { return consumed_; }   // Total bytes fed so far
+    size_t pending() const { return carry_.size(); }  // Bytes held back for the next chunk
+
+private:
+    // Enum to represent the kind of token in progress at the end of the last chunk
+    enum State : uint8_t {
+        STATE_NONE,           // At a token boundary
+        STATE_WORD,           // Identifier or keyword
+        STATE_NUMBER,         // pp-number; quotePending_ if it ended on a digit separator
+        STATE_LINE_COMMENT,   // "//" comment
+        STATE_BLOCK_COMMENT,  // "/*" comment; star_ if it ended on a '*'
+        STATE_LITERAL,        // String or char literal in quote_; escape_ if it ended on a backslash
+        STATE_DIRECTIVE,      // Preprocessor directive; part_ says where inside it
+        STATE_OPERATOR,       // Operator bytes that more input could still turn into a longer spelling
+    };
+
+    // Enum to represent the position inside a directive that is in progress
+    enum DirectivePart : uint8_t {
+        PART_PLAIN,            // Ordinary directive text
+        PART_SLASH,            // Just after a '/' that may open a comment
+        PART_LINE_COMMENT,     // In a "//" comment
+        PART_BLOCK_COMMENT,    // In a "/*" comment; star_ as for STATE_BLOCK_COMMENT
+        PART_QUOTE,            // In a quoted run closed by quote_ or the line end
+        PART_QUOTE_ESCAPE,     // Just after a backslash in a quoted run
+        PART_QUOTE_ESCAPE_CR,  // Just after a backslash and '\r' in a quoted run
+    };
+
+    // Enum to represent the outcome of resuming the token in progress
+    enum Advance : uint8_t {
+        ADVANCE_OPEN,   // The chunk ran out inside the token
+        ADVANCE_DONE,   // The token ends at the returned position
+        ADVANCE_SPLIT,  // A pp-number ends before its carried trailing quote
+    };
+
+    // Structure pairing a token in out with its text in done_, filled in once done_ stops growing
+    struct OwnedText {
+        size_t index;
+        size_t offset;
+        size_t length;
+    };
+
+    // Lex chunk from the boundary at i, holding back the token still in progress at its end
+    void lexChunk(std::string_view chunk, size_t i, std::vector<StreamToken>& out);
+
+    // Decide whether a token reaching into the last lookahead bytes is final; if not, enter its state
+    bool settle(std::string_view chunk, const TokenSpan& token);
+
+    // Continue the token in progress with chunk (or end it, if final); returns where the boundary is
+    size_t resume(std::string_view chunk, bool final, std::vector<StreamToken>& out);
+
+    // Scan chunk from i onward in the current state
+    Advance advance(std::string_view chunk, size_t& i);
+    Advance advanceDirective(std::string_view chunk, size_t& i);
+
+    // Settle carried operator bytes with the next bytes of chunk, or at the end of input
+    Advance resolveOperator(std::string_view chunk, size_t& i, bool final, std::vector<StreamToken>& out);
+
+    // Byte that lies back bytes before chunk[i] in the token in progress
+    char byteBefore(std::string_view chunk, size_t i, size_t back) const;
+
+    // Emit a token whose text is not inside the current chunk
+    void emitOwned(TokenType type, uint64_t offset, std::string_view text, std::vector<StreamToken>& out);
+
+    // Emit the token in progress, ending at chunk[end], and return to a boundary
+    void completeToken(std::string_view chunk, size_t end, std::vector<StreamToken>& out);
+
+    State state_ = STATE_NONE;
+    DirectivePart part_ = PART_PLAIN;
+    char quote_ = 0;              // Closing quote of the literal or quoted directive run
+    bool escape_ = false;         // A literal's backslash is waiting for the byte it escapes
+    bool star_ = false;           // A comment's last byte is a '*' that may close it
+    bool quotePending_ = false;   // A pp-number's last byte is a quote that the next byte decides
+    size_t tokenBegin_ = 0;       // Where the chunk part of the token in progress starts
+    std::string carry_;           // Bytes of the token in progress from earlier chunks
+    uint64_t carryOffset_ = 0;    // Stream offset of carry_[0]
+    std::string done_;            // Text of emitted tokens that began in an earlier chunk
+    std::vector<OwnedText> owned_;
+    uint64_t chunkBase_ = 0;      // Stream offset of the current chunk
+    uint64_t consumed_ = 0;
+};
+
+#endif // STREAMLEXER_H
@@ -0,0 +1,76 @@
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+
+// Dense integer handle for an interned identifier
+typedef uint32_t SymbolId;
+
+// SymbolId carried by tokens that are not identifiers
+constexpr SymbolId NO_SYMBOL = UINT32_MAX;
+
+// Thread-safe identifier interner. Each distinct name gets the next SymbolId
+// (0, 1, 2, ...) the first time it is interned, and the same id every time
+// after, so identifiers can be compared and hashed as integers. Names are
+// copied into the table once; text() views stay valid for its lifetime.
+// The name-to-id map is split into independently locked shards, so threads
+// interning different names rarely wait on each other. Resolving an id back
+// to text takes no lock at all.
+class SymbolTable {
+public:
+    SymbolTable();
+    ~SymbolTable();
+
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    // Return the id of name, adding it if it is new
+    SymbolId intern(std::string_view name);
+
+    // Return the id of name, or NO_SYMBOL if it has never been interned
+    SymbolId find(std::string_view name) const;
+
+    // Return the text of an id returned by intern()
+    std::string_view text(SymbolId id) const;
+
+    // Number of distinct names interned so far. An id is counted once its text
+    // is stored, but ids are not stored in order: while other threads intern,
+    // an id below size() may still be on its way. With no intern() running,
+    // the ids are exactly 0 to size() - 1.
+    size_t size() const { return published_.load(std::memory_order_acquire); }
+
+private:
+    static constexpr size_t shardCount = 16;
+    static constexpr size_t segmentCount = 22;   // Enough segments for 2^32 ids
+    static constexpr size_t firstSegment = 1024; // Size of segment 0; each next one doubles
+
+    // Open-addressing slot; the full hash is kept to skip most text compares
+    struct Slot {
+        uint32_t hash;
+        SymbolId id;
+    };
+
+    struct alignas(64) Shard {
+        mutable std::mutex lock;
+        std::vector<Slot> slots;  // Power-of-two sized, id NO_SYMBOL when empty
+        size_t used = 0;
+        Arena names;              // Storage for the names first seen in this shard
+    };
+
+    SymbolId findLocked(const Shard& shard, std::string_view name, uint64_t hash) const;
+    void publish(SymbolId id, std::string_view name);
+
+    Shard shards_[shardCount];
+    std::atomic<uint32_t> next_;       // Next id to hand out
+    std::atomic<uint32_t> published_;  // Ids whose text has been stored
+
+    // id -> text, in segments that are never moved once allocated
+    std::atomic<std::string_view*> segments_[segmentCount];
+};
+
+#endif // SYMBOLTABLE_H
@@ -0,0 +1,279 @@
+// The tokenize() loop as it was before the character-class table: a cascade
+// of locale-sensitive <cctype> tests per character. Copied unchanged apart
+// from the namespace, offsets on the tokens and unsigned char arguments to
+// the <cctype> calls. lexer_test diffs the Lexer against it.
+#include "legacytokenizer.h"
+#include <cctype>
+#include <unordered_set>
+
+// In a namespace of its own, since tokenizer.h declares the current helpers under the same names
+namespace legacy {
+
+// Set of C++ keywords for quick lookup
+const std::unordered_set<std::string> keywords = {
+    "int", "float", "double", "bool", "return", "void", "namespace", "enum",
+    "if", "else", "for", "while", "do", "switch", "case", "break", "continue",
+    "default", "static", "const", "class", "struct", "public", "private", "protected",
+    "virtual", "override", "new", "delete", "try", "catch", "throw", "using", "asm",
+    "auto", "char", "extern", "friend", "inline", "long", "register", "signed", "short",
+    "this", "typedef", "union", "unsigned", "volatile", "template"
+};
+
+// Check if a string is a keyword
+bool isKeyword(const std::string& str) {
+    return keywords.find(str) != keywords.end();
+}
+
+// Check if a character is a valid operator
+bool isOperator(char c) {
+    return (c == '+' || c == '-' || c == '*' || c == '/' || c == '=' ||
+        c == '<' || c == '>' || c == '!' || c == '&' || c == '|' ||
+        c == '^' || c == '%' || c == '~');
+}
+
+// Check for multi-character operators (e.g., <<, >>, <=, >=, ==, !=, ++, --, **)
+bool isMultiCharOperator(const std::string& input, size_t i) {
+    if (i + 1 >= input.length()) return false;
+    char next = input[i + 1];
+    char current = input[i];
+
+    return (current == '<' && next == '<') || (current == '>' && next == '>') ||
+        (current == '<' && next == '=') || (current == '>' && next == '=') ||
+        (current == '=' && next == '=') || (current == '!' && next == '=') ||
+        (current == '+' && next == '+') || (current == '-' && next == '-') ||
+        (current == '*' && next == '*');
+}
+
+TokenType wordToTokenType(const std::string& word);
+
+std::vector<Token> tokenize(const std::string& input) {
+    std::vector<Token> tokens;
+    size_t length = input.length();
+    size_t i = 0;
+
+    while (i < length) {
+        char current = input[i];
+        unsigned char byte = static_cast<unsigned char>(current);
+        uint32_t start = static_cast<uint32_t>(i);
+
+        // Skip whitespace
+        if (isspace(byte)) {
+            i++;
+            continue;
+        }
+
+        // Handle preprocessor directives
+        if (current == '#') {
+            std::string directive;
+            while (i < length && input[i] != '\n') {
+                directive += input[i++];
+            }
+            tokens.push_back(Token(TOK_HEADER, directive, start));
+            continue;
+        }
+
+        // Handle multi-character operators (e.g., ==, <=, ++, **)
+        if (isMultiCharOperator(input, i)) {
+            tokens.push_back(Token(TOK_OPERATOR, input.substr(i, 2), start));  // Capture two-character operator
+            i += 2;
+            continue;
+        }
+
+        // Handle single-line comments
+        if (current == '/' && i + 1 < length && input[i + 1] == '/') {
+            std::string comment;
+            while (i < length && input[i] != '\n') {
+                comment += input[i++];
+            }
+            tokens.push_back(Token(TOK_COMMENT, comment, start));
+            continue;
+        }
+
+        // Handle Scope Resolutiona
+        if (current == ':' && i + 1 < length && input[i + 1] == ':') {
+            tokens.push_back(Token(TOK_SCOPE, "::", start));
+            i += 2;
+            continue;
+        }
+
+        // Handle multi-line comments
+        if (current == '/' && i + 1 < length && input[i + 1] == '*') {
+            std::string comment = "/*";
+            i += 2;
+            while (i + 1 < length && !(input[i] == '*' && input[i + 1] == '/')) {
+                comment += input[i++];
+            }
+            if (i + 1 < length) {
+                comment += "*/";
+                i += 2;
+            }
+            tokens.push_back(Token(TOK_COMMENT, comment, start));
+            continue;
+        }
+
+        // Handle keywords, identifiers, and template keyword
+        if (isalpha(byte) || current == '_') {
+            std::string word;
+            while (i < length && (isalnum(static_cast<unsigned char>(input[i])) || input[i] == '_')) {
+                word += input[i++];
+            }
+
+            if (isKeyword(word)) {
+                tokens.push_back(Token(wordToTokenType(word), word, start));
+            }
+            else {
+                tokens.push_back(Token(TOK_IDENTIFIER, word, start));
+            }
+            continue;
+        }
+
+        // Handle numbers (integers and floats)
+        if (isdigit(byte)) {
+            std::string number;
+            while (i < length && (isdigit(static_cast<unsigned char>(input[i])) || input[i] == '.')) {
+                number += input[i++];
+            }
+            tokens.push_back(Token(TOK_NUMBER, number, start));
+            continue;
+        }
+
+        // Handle multi-character operators (e.g., ==, <=)
+        if (isMultiCharOperator(input, i)) {
+            tokens.push_back(Token(TOK_OPERATOR, input.substr(i, 2), start));
+            i += 2;
+            continue;
+        }
+
+        // Handle single-character operators
+        if (isOperator(current)) {
+            tokens.push_back(Token(TOK_OPERATOR, std::string(1, current), start));
+            i++;
+            continue;
+        }
+
+        // Handle punctuation (e.g., ';', '{', '}', '(', ')')
+        if (ispunct(byte) && current != '"' && current != '\'') {
+            tokens.push_back(Token(TOK_PUNCTUATION, std::string(1, current), start));
+            i++;
+            continue;
+        }
+
+        // Handle string literals
+        if (current == '\"') {
+            std::string strLit;
+            strLit += current;
+            i++;
+            while (i < length && input[i] != '\"') {
+                if (input[i] == '\\' && i + 1 < length) {
+                    strLit += input[i++];  // Handle escape sequences in strings
+                }
+                strLit += input[i++];
+            }
+            if (i < length) {
+                strLit += input[i++]; // Add closing quote
+            }
+            tokens.push_back(Token(TOK_STRING, strLit, start));
+            continue;
+        }
+
+        // Handle character literals (e.g., 'a')
+        if (current == '\'') {
+            std::string charLit;
+            charLit += current;
+            i++;
+            while (i < length && input[i] != '\'') {
+                if (input[i] == '\\' && i + 1 < length) {
+                    charLit += input[i++];  // Handle escape sequences in char literals
+                }
+                charLit += input[i++];
+            }
+            if (i < length) {
+                charLit += input[i++]; // Add closing quote
+            }
+            tokens.push_back(Token(TOK_CHAR, charLit, start));
+            continue;
+        }
+
+        // Handle member access (e.g., ., ->)
+        if (current == '.' || current == '-') {
+            if (current == '-' && i + 1 < length && input[i + 1] == '>') {
+                tokens.push_back(Token(TOK_PUNCTUATION, "->", start));
+                i += 2;
+            }
+            else {
+                tokens.push_back(Token(TOK_PUNCTUATION, ".", start));
+                i++;
+            }
+            continue;
+        }
+
+        
+
+        // Handle unknown characters
+        tokens.push_back(Token(TOK_UNKNOWN, std::string(1, current), start));
+        i++;
+    }
+
+    return tokens;
+}
+
+// Map keyword strings to TokenType
+TokenType wordToTokenType(const std::string& word) {
+    if (word == "int") return TOK_INT;
+    if (word == "float") return TOK_FLOAT;
+    if (word == "double") return TOK_DOUBLE;
+    if (word == "bool") return TOK_BOOL;
+    if (word == "return") return TOK_RETURN;
+    if (word == "void") return TOK_VOID;
+    if (word == "namespace") return TOK_NAMESPACE;
+    if (word == "enum") return TOK_ENUM;
+    if (word == "if") return TOK_IF;
+    if (word == "else") return TOK_ELSE;
+    if (word == "for") return TOK_FOR;
+    if (word == "while") return TOK_WHILE;
+    if (word == "do") return TOK_DO;
+    if (word == "switch") return TOK_SWITCH;
+    if (word == "case") return TOK_CASE;
+    if (word == "break") return TOK_BREAK;
+    if (word == "continue") return TOK_CONTINUE;
+    if (word == "default") return TOK_DEFAULT;
+    if (word == "static") return TOK_STATIC;
+    if (word == "const") return TOK_CONST;
+    if (word == "class") return TOK_CLASS;
+    if (word == "struct") return TOK_STRUCT;
+    if (word == "public") return TOK_PUBLIC;
+    if (word == "private") return TOK_PRIVATE;
+    if (word == "protected") return TOK_PROTECTED;
+    if (word == "virtual") return TOK_VIRTUAL;
+    if (word == "override") return TOK_OVERRIDE;
+    if (word == "new") return TOK_NEW;
+    if (word == "delete") return TOK_DELETE;
+    if (word == "try") return TOK_TRY;
+    if (word == "catch") return TOK_CATCH;
+    if (word == "throw") return TOK_THROW;
+    if (word == "using") return TOK_USING;
+    if (word == "asm") return TOK_ASM;
+    if (word == "auto") return TOK_AUTO;
+    if (word == "char") return TOK_CHAR;
+    if (word == "extern") return TOK_EXTERN;
+    if (word == "friend") return TOK_FRIEND;
+    if (word == "inline") return TOK_INLINE;
+    if (word == "long") return TOK_LONG;
+    if (word == "register") return TOK_REGISTER;
+    if (word == "signed") return TOK_SIGNED;
+    if (word == "short") return TOK_SHORT;
+    if (word == "this") return TOK_THIS;
+    if (word == "typedef") return TOK_TYPEDEF;
+    if (word == "union") return TOK_UNION;
+    if (word == "unsigned") return TOK_UNSIGNED;
+    if (word == "volatile") return TOK_VOLATILE;
+
+    // If not a keyword, return generic keyword token
+    return TOK_KEYWORD;
+}
+
+} // namespace legacy
+
+std::vector<Token> legacyTokenize(const std::string& input) {
+    return legacy::tokenize(input);
+}
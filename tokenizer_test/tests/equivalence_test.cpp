@@ -0,0 +1,568 @@
+// Every alternative way of producing tokens must give exactly tokenize(x):
+// the SIMD scan levels, each LexPolicy (less the kinds it drops, with stats
+// that account for every byte), StreamLexer over any chunking,
+// tokenizeParallel, IncrementalLexer after edits, tokenizeArena, tokenizeFile
+// on files that are mapped and on those that are read, the binary format
+// round trip, the token cache (including damaged entries) and the dependency
+// scanner's directive subset. SymbolTable interning from several threads must
+// likewise give what interning on one thread would: one dense id per distinct
+// name.
+#include <algorithm> // For std::min
+#include <cstdio>
+#include <cstring>   // For memcpy
+#include <filesystem>
+#include <fstream>
+#include <random>    // For std::random_device
+#include <stdexcept> // For std::runtime_error
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "arena.h"
+#include "dependencyscan.h"
+#include "incrementallexer.h"
+#include "lexer.h"
+#include "mappedfile.h"
+#include "parallel.h"
+#include "scan.h"
+#include "streamlexer.h"
+#include "symboltable.h"
+#include "tokenbinary.h"
+#include "tokencache.h"
+#include "testutil.h"
+
+#ifndef _WIN32
+#include <csignal>    // For std::signal
+#include <sys/stat.h> // For mkfifo
+#endif
+
+// Edge cases plus generated sources of a range of sizes
+static std::vector<std::string> testSources() {
+    std::vector<std::string> sources = edgeCaseSources();
+    SourceGenerator generator(7);
+    for (int round = 0; round < 150; round++) {
+        sources.push_back(generator.make(generator.between(1, round < 100 ? 100 : 3000)));
+    }
+    return sources;
+}
+
+static std::vector<TokenSpan> reference(std::string_view source) {
+    std::vector<TokenSpan> tokens;
+    tokenize(source, tokens);
+    return tokens;
+}
+
+static void testScanLevels(const std::vector<std::string>& sources) {
+    ScanLevel best = bestScanLevel();
+    for (int level = SCAN_SCALAR; level <= best; level++) {
+        setScanLevel(static_cast<ScanLevel>(level));
+        for (const std::string& source : sources) {
+            setScanLevel(SCAN_SCALAR);
+            std::vector<TokenSpan> expected = reference(source);
+            setScanLevel(static_cast<ScanLevel>(level));
+            sameTokens(scanLevelName(static_cast<ScanLevel>(level)), source, expected, reference(source));
+        }
+    }
+    setScanLevel(best);
+}
+
+// A policy's tokens are the full stream with the kinds it drops filtered out
+template <typename Policy>
+static void checkPolicy(const char* what, const std::string& source, const std::vector<TokenSpan>& full) {
+    std::vector<TokenSpan> expected;
+    for (const TokenSpan& token : full) {
+        if ((Policy::keepComments || token.type != TOK_COMMENT) && (Policy::keepDirectives || !isDirective(token.type))) {
+            expected.push_back(token);
+        }
+    }
+    std::vector<TokenSpan> actual;
+    tokenize<Policy>(std::string_view(source), actual);
+    sameTokens(what, source, expected, actual);
+}
+
+static void testPolicies(const std::vector<std::string>& sources) {
+    for (const std::string& source : sources) {
+        std::vector<TokenSpan> full = reference(source);
+        checkPolicy<LexPolicy<true, true>>("FullPolicy", source, full);
+        checkPolicy<LexPolicy<true, false>>("LexPolicy<true, false>", source, full);
+        checkPolicy<LexPolicy<false, true>>("LexPolicy<false, true>", source, full);
+        checkPolicy<LexPolicy<false, false>>("CodePolicy", source, full);
+        checkPolicy<LexPolicy<true, true, true>>("StatsPolicy", source, full);
+        checkPolicy<LexPolicy<true, false, true>>("LexPolicy<true, false, true>", source, full);
+        checkPolicy<LexPolicy<false, true, true>>("LexPolicy<false, true, true>", source, full);
+        checkPolicy<LexPolicy<false, false, true>>("LexPolicy<false, false, true>", source, full);
+    }
+}
+
+// An instrumented policy accounts for every byte of the source once, and its
+// token counts are those of the full stream less the kinds it drops
+template <typename Policy>
+static void checkStats(const char* what, const std::string& source, const std::vector<TokenSpan>& full) {
+    BasicLexer<Policy> lexer(source);
+    std::vector<TokenSpan> tokens;
+    lexer.drain(tokens);
+    const LexerStats& stats = lexer.stats();
+
+    uint64_t branchBytes = 0;
+    uint64_t lexemes = 0;
+    for (int branch = 0; branch < LEX_BRANCH_COUNT; branch++) {
+        branchBytes += stats.branchBytes[branch];
+        lexemes += branch == LEX_WHITESPACE ? 0 : stats.branchHits[branch];
+    }
+    if (branchBytes != source.length() || lexemes != full.size()) {
+        fail("%s: branches took %llu bytes in %llu lexemes, expected %zu in %zu (source %s)", what,
+             static_cast<unsigned long long>(branchBytes), static_cast<unsigned long long>(lexemes),
+             source.length(), full.size(), printable(source).c_str());
+    }
+
+    uint64_t counts[TOKEN_TYPE_COUNT] = {};
+    uint64_t bytes[TOKEN_TYPE_COUNT] = {};
+    size_t kept = 0;
+    for (const TokenSpan& token : full) {
+        if ((Policy::keepComments || token.type != TOK_COMMENT) && (Policy::keepDirectives || !isDirective(token.type))) {
+            counts[token.type]++;
+            bytes[token.type] += token.length;
+            kept++;
+        }
+    }
+    for (size_t type = 0; type < TOKEN_TYPE_COUNT; type++) {
+        if (stats.tokens[type] != counts[type] || stats.bytes[type] != bytes[type]) {
+            fail("%s: %llu %s tokens of %llu bytes, expected %llu of %llu (source %s)", what,
+                 static_cast<unsigned long long>(stats.tokens[type]),
+                 std::string(tokenTypeName(static_cast<TokenType>(type))).c_str(),
+                 static_cast<unsigned long long>(stats.bytes[type]), static_cast<unsigned long long>(counts[type]),
+                 static_cast<unsigned long long>(bytes[type]), printable(source).c_str());
+        }
+    }
+    CHECK(stats.totalTokens() == kept && tokens.size() == kept);
+}
+
+static void testStats(const std::vector<std::string>& sources) {
+    for (const std::string& source : sources) {
+        std::vector<TokenSpan> full = reference(source);
+        checkStats<StatsPolicy>("StatsPolicy", source, full);
+        checkStats<LexPolicy<true, false, true>>("LexPolicy<true, false, true>", source, full);
+        checkStats<LexPolicy<false, true, true>>("LexPolicy<false, true, true>", source, full);
+        checkStats<LexPolicy<false, false, true>>("LexPolicy<false, false, true>", source, full);
+    }
+}
+
+// Feed source in pieces of chunkSize bytes (0 = random sizes) and collect the stream tokens
+static std::vector<TokenSpan> streamTokens(const std::string& source, size_t chunkSize, SourceGenerator& generator,
+    std::string_view& failure) {
+    StreamLexer lexer;
+    std::vector<StreamToken> streamed;
+    std::vector<TokenSpan> tokens;
+    auto collect = [&]() {
+        for (const StreamToken& token : streamed) {
+            // Text views are only valid until the next feed(), so check them now
+            if (token.text != std::string_view(source).substr(token.offset, token.text.length())) {
+                failure = "token text does not match the source";
+            }
+            tokens.push_back(TokenSpan{ token.type, static_cast<uint32_t>(token.offset),
+                static_cast<uint32_t>(token.text.length()) });
+        }
+        streamed.clear();
+    };
+
+    size_t i = 0;
+    while (i < source.length()) {
+        size_t size = chunkSize ? chunkSize : generator.between(1, 97);
+        size = std::min(size, source.length() - i);
+        lexer.feed(std::string_view(source).substr(i, size), streamed);
+        collect();
+        i += size;
+    }
+    lexer.finish(streamed);
+    collect();
+    return tokens;
+}
+
+static void testStreamLexer(const std::vector<std::string>& sources) {
+    SourceGenerator generator(11);
+    const size_t chunkSizes[] = { 1, 2, 3, 4, 5, 7, 64, 4096, 0, 0 };
+    for (const std::string& source : sources) {
+        std::vector<TokenSpan> expected = reference(source);
+        for (size_t chunkSize : chunkSizes) {
+            std::string_view failure;
+            std::vector<TokenSpan> actual = streamTokens(source, chunkSize, generator, failure);
+            std::string what = "StreamLexer, " + (chunkSize ? std::to_string(chunkSize) : "random") + " byte chunks";
+            if (!failure.empty()) {
+                fail("%s: %.*s (source %s)", what.c_str(), int(failure.length()), failure.data(), printable(source).c_str());
+            }
+            if (!sameTokens(what.c_str(), source, expected, actual)) {
+                break;
+            }
+        }
+    }
+}
+
+static void testParallel(const std::vector<std::string>& sources) {
+    for (const std::string& source : sources) {
+        std::vector<TokenSpan> expected = reference(source);
+        for (unsigned threads = 1; threads <= 4; threads++) {
+            for (size_t minChunk : { size_t(1), size_t(13), size_t(256) }) {
+                ParallelOptions options;
+                options.threads = threads;
+                options.minChunkBytes = minChunk;
+                std::vector<TokenSpan> actual;
+                tokenizeParallel(source, actual, options);
+                std::string what = "tokenizeParallel, " + std::to_string(threads) + " threads, chunks of " +
+                    std::to_string(minChunk) + "+ bytes";
+                sameTokens(what.c_str(), source, expected, actual);
+            }
+        }
+    }
+}
+
+// Threads intern overlapping word sets, each in its own order, twice over
+static void testSymbolTable() {
+    const size_t threadCount = 8;
+    const size_t wordCount = 20000;
+    const size_t wordsPerThread = 6000;
+    std::vector<std::string> words;
+    for (size_t i = 0; i < wordCount; i++) {
+        words.push_back("name" + std::to_string(i * 7919 % 100003));
+    }
+
+    SymbolTable table;
+    std::vector<std::vector<SymbolId>> ids(threadCount, std::vector<SymbolId>(wordCount, NO_SYMBOL));
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t] {
+            SourceGenerator generator(100 + static_cast<uint32_t>(t));
+            size_t first = t * (wordCount - wordsPerThread) / (threadCount - 1);
+            for (int pass = 0; pass < 2; pass++) {
+                for (size_t k = 0; k < wordsPerThread; k++) {
+                    size_t w = first + (pass == 0 ? generator.between(0, wordsPerThread - 1) : k);
+                    SymbolId id = table.intern(words[w]);
+                    if (ids[t][w] != NO_SYMBOL && ids[t][w] != id) {
+                        ids[t][w] = NO_SYMBOL - 1;  // Reported below as a mismatch
+                    }
+                    else {
+                        ids[t][w] = id;
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    // Every word was interned by some thread; all threads agree on its id
+    std::vector<SymbolId> agreed(wordCount, NO_SYMBOL);
+    for (size_t t = 0; t < threadCount; t++) {
+        for (size_t w = 0; w < wordCount; w++) {
+            if (ids[t][w] == NO_SYMBOL) {
+                continue;
+            }
+            if (agreed[w] != NO_SYMBOL && agreed[w] != ids[t][w]) {
+                fail("SymbolTable: %s got ids %u and %u", words[w].c_str(), agreed[w], ids[t][w]);
+            }
+            agreed[w] = ids[t][w];
+        }
+    }
+
+    // The ids are exactly 0 to size() - 1, and each maps back to its word
+    CHECK(table.size() == wordCount);
+    std::vector<bool> seen(wordCount, false);
+    for (size_t w = 0; w < wordCount; w++) {
+        SymbolId id = agreed[w];
+        if (id >= wordCount || seen[id]) {
+            fail("SymbolTable: %s has id %u, out of range or not unique", words[w].c_str(), id);
+            continue;
+        }
+        seen[id] = true;
+        CHECK(table.text(id) == words[w]);
+        CHECK(table.find(words[w]) == id);
+    }
+    CHECK(table.find("never interned") == NO_SYMBOL);
+}
+
+static void testIncremental(const std::vector<std::string>& sources) {
+    static const char* const insertions[] = {
+        "", "x", " ", "\n", "/*", "*/", "//", "\"", "'", "\\", "#define Q 1\n", "+", "=", ".", "1'", "abc def",
+    };
+    SourceGenerator generator(23);
+    for (const std::string& original : sources) {
+        std::string source = original;
+        IncrementalLexer lexer(source);
+        for (int step = 0; step < 20; step++) {
+            TextEdit change;
+            change.offset = generator.between(0, source.length());
+            change.removed = generator.between(0, std::min<size_t>(source.length() - change.offset, 8));
+            std::string inserted = insertions[generator.between(0, sizeof(insertions) / sizeof(insertions[0]) - 1)];
+            change.inserted = inserted.length();
+            source.replace(change.offset, change.removed, inserted);
+
+            lexer.edit(source, change);
+            std::vector<TokenSpan> actual;
+            lexer.copyTo(actual);
+            if (!sameTokens("IncrementalLexer after an edit", source, reference(source), actual)) {
+                break;
+            }
+        }
+    }
+}
+
+static void testBinaryRoundTrip(const std::vector<std::string>& sources) {
+    for (const std::string& source : sources) {
+        std::vector<TokenSpan> expected = reference(source);
+        for (bool withValues : { false, true }) {
+            std::string encoded;
+            writeTokens(source, expected, encoded, withValues);
+            TokenReader reader(encoded);
+            CHECK(reader.size() == expected.size());
+            CHECK(reader.sourceLength() == source.length());
+            CHECK(reader.hasValues() == withValues);
+
+            std::vector<TokenSpan> actual;
+            reader.readAll(actual);
+            sameTokens(withValues ? "readTokens(writeTokens(x, values))" : "readTokens(writeTokens(x))",
+                source, expected, actual);
+
+            // Values, where present, are the unescaped literal contents
+            reader.rewind();
+            DecodedToken token;
+            while (reader.next(token)) {
+                if (!token.hasValue) {
+                    continue;
+                }
+                std::string_view text = std::string_view(source).substr(token.offset, token.length);
+                std::string decoded(literalBody(text).length(), '\0');
+                decoded.resize(unescapeLiteral(text, &decoded[0]));
+                CHECK(token.value == decoded);
+            }
+
+            // A record whose type byte names no TokenType is a format error
+            if (!expected.empty()) {
+                // The first record follows the 6-byte header and three varints
+                size_t first = 6;
+                for (int varint = 0; varint < 3; varint++) {
+                    while (encoded[first] & 0x80) {
+                        first++;
+                    }
+                    first++;
+                }
+                for (uint8_t type : { uint8_t(24), uint8_t(TOK_EOF), uint8_t(TOK_PP_LINE + 1), uint8_t(255) }) {
+                    std::string corrupt = encoded;
+                    corrupt[first] = static_cast<char>(type);
+                    bool rejected = false;
+                    try {
+                        TokenReader(corrupt).readAll(actual);
+                    }
+                    catch (const std::runtime_error&) {
+                        rejected = true;
+                    }
+                    CHECK(rejected);
+                }
+            }
+        }
+    }
+}
+
+static std::string readFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void writeFile(const std::filesystem::path& path, const std::string& contents) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), contents.size());
+}
+
+// tokenizeArena gives the tokens of tokenize() with literal values decoded,
+// and one arena serves any number of sources when reset between them
+static void testArena(const std::vector<std::string>& sources) {
+    Arena arena(256);
+    size_t settled = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (const std::string& source : sources) {
+            arena.reset();
+            CHECK(arena.used() == 0);
+            std::string copy = source;
+            ArenaTokens tokens = tokenizeArena(copy, arena);
+            copy.assign(copy.length(), '#');  // The result must not depend on the input buffer
+
+            std::vector<TokenSpan> expected = reference(source);
+            std::vector<TokenSpan> actual;
+            for (const ArenaToken& token : tokens) {
+                actual.push_back(TokenSpan{ token.type, token.offset, static_cast<uint32_t>(token.text.length()) });
+                CHECK(token.text == std::string_view(source).substr(token.offset, token.text.length()));
+                if (token.type == TOK_STRING || token.type == TOK_CHAR) {
+                    std::string decoded(literalBody(token.text).length(), '\0');
+                    decoded.resize(unescapeLiteral(token.text, &decoded[0]));
+                    CHECK(token.value == decoded);
+                }
+                else {
+                    CHECK(token.value == token.text);
+                }
+            }
+            sameTokens("tokenizeArena", source, expected, actual);
+        }
+
+        // The kept block is the largest, so the second pass needs no new memory
+        if (pass == 0) {
+            settled = arena.capacity();
+        }
+        else {
+            CHECK(arena.capacity() == settled);
+        }
+    }
+}
+
+// tokenizeFile maps regular files and reads what cannot be mapped
+static void testMappedFile(const std::vector<std::string>& sources) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() /
+        ("equivalence_test_files_" + std::to_string(std::random_device()()));
+    std::filesystem::create_directories(directory);
+    std::filesystem::path path = directory / "source.cpp";
+    for (const std::string& source : sources) {
+        writeFile(path, source);
+        TokenizedFile file = tokenizeFile(path.string());
+        CHECK(file.source() == source);
+        sameTokens("tokenizeFile", source, reference(source), file.tokens);
+    }
+
+#ifndef _WIN32
+    // A FIFO has no size to map; its writer only gets to run once it is opened.
+    // If the reader gives up early, the write fails rather than killing the test.
+    std::signal(SIGPIPE, SIG_IGN);
+    const std::string& source = sources.back();
+    std::filesystem::path fifo = directory / "fifo";
+    CHECK(mkfifo(fifo.c_str(), 0600) == 0);
+    std::thread writer([&] { writeFile(fifo, source); });
+    TokenizedFile file = tokenizeFile(fifo.string());
+    writer.join();
+    CHECK(file.source() == source);
+    sameTokens("tokenizeFile, FIFO", source, reference(source), file.tokens);
+
+    // Moving keeps the read buffer, and the tokens that point into it, valid
+    TokenizedFile moved = std::move(file);
+    CHECK(moved.source() == source);
+#endif
+
+    bool threw = false;
+    try {
+        MappedFile file(directory.string());
+    }
+    catch (const std::system_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    std::filesystem::remove_all(directory);
+}
+
+// Path of the entry TokenCache keeps for source in directory
+static std::filesystem::path cacheEntry(const std::filesystem::path& directory, std::string_view source) {
+    char name[48];
+    std::snprintf(name, sizeof(name), "%016llx-v%u.tok",
+        static_cast<unsigned long long>(hashBytes(source.data(), source.length())), LEXER_VERSION);
+    return directory / name;
+}
+
+// Look source up and check the tokens against tokenize(); returns whether it was a hit
+static bool cacheLookup(TokenCache& cache, const char* what, std::string_view source) {
+    CachedTokens cached = cache.tokenize(source);
+    sameTokens(what, source, reference(source), std::vector<TokenSpan>(cached.begin(), cached.end()));
+    return cached.hit;
+}
+
+static void testTokenCache(const std::vector<std::string>& sources) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() /
+        ("equivalence_test_cache_" + std::to_string(std::random_device()()));
+    {
+        TokenCache cache(directory.string());
+        for (const std::string& source : sources) {
+            cacheLookup(cache, "TokenCache, first lookup", source);
+            CHECK(cacheLookup(cache, "TokenCache, second lookup", source));
+        }
+
+        // Damaged entries for a source with a few tokens; each must be a miss
+        // that still returns the right tokens (and rewrites the entry)
+        const std::string source = "int x = 42; // answer\n";
+        std::filesystem::path entry = cacheEntry(directory, source);
+        cacheLookup(cache, "TokenCache, miss", source);
+        CHECK(cacheLookup(cache, "TokenCache, hit", source));
+        const std::string good = readFile(entry);
+        const size_t header = 48;           // sizeof(CacheHeader)
+        const size_t countField = 40;       // CacheHeader::tokenCount
+        const size_t record = sizeof(TokenSpan);
+
+        // Another source of the same length finding this entry under its name
+        std::string other = source;
+        other[0] = 'I';
+        writeFile(cacheEntry(directory, other), good);
+        CHECK(!cacheLookup(cache, "TokenCache, stale source hash", other));
+
+        std::string damaged = good.substr(0, good.size() - 1);
+        writeFile(entry, damaged);
+        CHECK(!cacheLookup(cache, "TokenCache, truncated entry", source));
+
+        // A count whose byte size wraps around to the real one
+        damaged = good;
+        uint64_t count;
+        memcpy(&count, &damaged[countField], sizeof(count));
+        count += uint64_t(1) << 62;
+        memcpy(&damaged[countField], &count, sizeof(count));
+        writeFile(entry, damaged);
+        CHECK(!cacheLookup(cache, "TokenCache, wrapping token count", source));
+
+        damaged = good;
+        damaged[header] = 24;  // A gap in TokenType
+        writeFile(entry, damaged);
+        CHECK(!cacheLookup(cache, "TokenCache, invalid record type", source));
+
+        damaged = good;
+        uint32_t length = static_cast<uint32_t>(source.length()) + 1;
+        memcpy(&damaged[header + record + 8], &length, sizeof(length));  // Second record's length
+        writeFile(entry, damaged);
+        CHECK(!cacheLookup(cache, "TokenCache, record past the source", source));
+
+        damaged = good;
+        memcpy(&damaged[header + record + 4], &damaged[header + 4], sizeof(uint32_t));  // Second offset = first
+        writeFile(entry, damaged);
+        CHECK(!cacheLookup(cache, "TokenCache, records out of order", source));
+
+        CHECK(cacheLookup(cache, "TokenCache, rewritten entry", source));
+    }
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+}
+
+static void testDependencyScan(const std::vector<std::string>& sources) {
+    for (const std::string& source : sources) {
+        std::vector<TokenSpan> expected;
+        for (const TokenSpan& token : reference(source)) {
+            if (token.type == TOK_PP_INCLUDE || (token.type >= TOK_PP_IF && token.type <= TOK_PP_ENDIF)) {
+                expected.push_back(token);
+            }
+        }
+        std::vector<Dependency> dependencies;
+        scanDependencies(source, dependencies);
+        std::vector<TokenSpan> actual;
+        for (const Dependency& dependency : dependencies) {
+            actual.push_back(TokenSpan{ dependency.type, dependency.offset, dependency.length });
+        }
+        sameTokens("scanDependencies", source, expected, actual);
+    }
+}
+
+int main() {
+    std::vector<std::string> sources = testSources();
+    testScanLevels(sources);
+    testPolicies(sources);
+    testStats(sources);
+    testStreamLexer(sources);
+    testParallel(sources);
+    testSymbolTable();
+    testIncremental(sources);
+    testArena(sources);
+    testMappedFile(sources);
+    testBinaryRoundTrip(sources);
+    testTokenCache(sources);
+    testDependencyScan(sources);
+    std::printf("equivalence_test: %d failures\n", failureCount());
+    return failureCount() ? 1 : 0;
+}
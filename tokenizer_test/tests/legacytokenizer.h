@@ -0,0 +1,12 @@
+#ifndef LEGACYTOKENIZER_H
+#define LEGACYTOKENIZER_H
+
+#include <string>
+#include <vector>
+#include "tokenizer.h"
+
+// Function to tokenize with the original character-cascade loop that the
+// table-driven Lexer replaced; kept only as the reference for lexer_test
+std::vector<Token> legacyTokenize(const std::string& input); // Function declaration
+
+#endif // LEGACYTOKENIZER_H
@@ -0,0 +1,650 @@
+// Differential test of the Lexer against the legacy tokenize() loop, plus the
+// token output expected for edge cases and for the places where the Lexer
+// deliberately departs from the legacy output.
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "directive.h"
+#include "legacytokenizer.h"
+#include "lexer.h"
+#include "testutil.h"
+#include "tokendump.h"
+#include "tokenstream.h"
+
+// Fragments both lexers must split and type identically when separated by
+// whitespace. Operators are limited to the legacy spellings; directives are
+// compared by text only, since the Lexer types them by name.
+static std::string commonSource(SourceGenerator& generator, size_t fragments) {
+    static const char* const pieces[] = {
+        "int", "float", "return", "while", "template", "x", "_y9", "camelCase", "identifier_long_enough",
+        "0", "42", "3.14", "1.2.3", "+", "-", "*", "/", "=", "<", ">", "!", "&", "|", "^", "%", "~",
+        "<<", ">>", "<=", ">=", "==", "!=", "++", "--", "(", ")", "[", "]", "{", "}", ";", ",", "?",
+        ":", ".", "::", "\"str\"", "\"esc\\\"aped\\\\\"", "\"multi\nline\"", "'c'", "'\\n'", "'\\''",
+        "// line comment\n", "/* block */", "/* multi\nline * / */", "#include <vector>\n",
+        "#define M(a) a\n", "#endif\n",
+    };
+    static const char* const spaces[] = { " ", "\n", "\t", "  ", "\r\n" };
+    std::string out;
+    for (size_t k = 0; k < fragments; k++) {
+        out += pieces[generator.between(0, sizeof(pieces) / sizeof(pieces[0]) - 1)];
+        out += spaces[generator.between(0, sizeof(spaces) / sizeof(spaces[0]) - 1)];
+    }
+    return out;
+}
+
+static void testAgainstLegacy() {
+    SourceGenerator generator(4);
+    for (int round = 0; round < 500; round++) {
+        std::string source = commonSource(generator, generator.between(1, 300));
+        std::vector<Token> expected = legacyTokenize(source);
+        std::vector<Token> actual = tokenize(source);
+
+        size_t k = 0;
+        while (k < expected.size() && k < actual.size()) {
+            TokenType type = isDirective(actual[k].type) ? TOK_HEADER : actual[k].type;
+            if (type != expected[k].type || actual[k].value != expected[k].value ||
+                actual[k].offset != expected[k].offset) {
+                break;
+            }
+            k++;
+        }
+        if (k < expected.size() || k < actual.size()) {
+            std::string want = k < expected.size() ?
+                tokenTypeToString(expected[k].type) + " " + printable(expected[k].value) : "nothing";
+            std::string got = k < actual.size() ?
+                tokenTypeToString(actual[k].type) + " " + printable(actual[k].value) : "nothing";
+            fail("legacy: token %zu is %s, the legacy loop gives %s (source %s)", k, got.c_str(), want.c_str(),
+                printable(source, 400).c_str());
+            return;
+        }
+    }
+}
+
+// Structure pairing an input with the tokens it must produce, as "TYPE text" lines
+struct ExpectedLexing {
+    const char* source;
+    std::vector<std::string> tokens;
+};
+
+static void testExpectedTokens() {
+    const ExpectedLexing cases[] = {
+        // Unterminated constructs run to the end of the input
+        { "/* unterminated", { "TOK_COMMENT /* unterminated" } },
+        { "x /*", { "TOK_IDENTIFIER x", "TOK_COMMENT /*" } },
+        { "/*/", { "TOK_COMMENT /*/" } },
+        { "\"unterminated string", { "TOK_STRING \"unterminated string" } },
+        { "\"ends with backslash\\", { "TOK_STRING \"ends with backslash\\" } },
+        { "'a", { "TOK_CHAR 'a" } },
+        // Backslash-newline continues literals and directives, not line comments
+        { "\"a\\\nb\" c", { "TOK_STRING \"a\\\nb\"", "TOK_IDENTIFIER c" } },
+        { "// a \\\nb", { "TOK_COMMENT // a \\", "TOK_IDENTIFIER b" } },
+        { "#define A 1 \\\n + 2\nx", { "TOK_PP_DEFINE #define A 1 \\\n + 2", "TOK_IDENTIFIER x" } },
+        { "#define A 1 \\\r\n + 2\r\nx", { "TOK_PP_DEFINE #define A 1 \\\r\n + 2\r", "TOK_IDENTIFIER x" } },
+        { "a\\\nb", { "TOK_IDENTIFIER a", "TOK_PUNCTUATION \\", "TOK_IDENTIFIER b" } },
+        // Departures from the legacy loop: maximal munch over the full operator set
+        { "a&&b", { "TOK_IDENTIFIER a", "TOK_OPERATOR &&", "TOK_IDENTIFIER b" } },
+        { "x**2", { "TOK_IDENTIFIER x", "TOK_OPERATOR *", "TOK_OPERATOR *", "TOK_NUMBER 2" } },
+        { "p->q", { "TOK_IDENTIFIER p", "TOK_PUNCTUATION ->", "TOK_IDENTIFIER q" } },
+        { "a<<=b", { "TOK_IDENTIFIER a", "TOK_OPERATOR <<=", "TOK_IDENTIFIER b" } },
+        { "f(...)", { "TOK_IDENTIFIER f", "TOK_PUNCTUATION (", "TOK_PUNCTUATION ...", "TOK_PUNCTUATION )" } },
+        // ... whole pp-numbers ...
+        { "0x1Fu 1'000 1e+5f .5", { "TOK_NUMBER 0x1Fu", "TOK_NUMBER 1'000", "TOK_NUMBER 1e+5f", "TOK_NUMBER .5" } },
+        // ... and typed directives whose comments and continuations belong to them
+        { "#include <a.h> // c\n", { "TOK_PP_INCLUDE #include <a.h> // c" } },
+        { "#if A /* x\ny */ B\n", { "TOK_PP_IF #if A /* x\ny */ B" } },
+        { "#pragma once", { "TOK_PP_PRAGMA #pragma once" } },
+        { "#", { "TOK_HEADER #" } },
+        // Like the legacy loop, a '#' anywhere outside a literal or comment starts a directive
+        { "x # define y\nz", { "TOK_IDENTIFIER x", "TOK_PP_DEFINE # define y", "TOK_IDENTIFIER z" } },
+        { "a; #if B", { "TOK_IDENTIFIER a", "TOK_PUNCTUATION ;", "TOK_PP_IF #if B" } },
+    };
+
+    for (const ExpectedLexing& expected : cases) {
+        std::string source = expected.source;
+        std::vector<Token> tokens = tokenize(source);
+        std::vector<std::string> actual;
+        for (const Token& token : tokens) {
+            actual.push_back(tokenTypeToString(token.type) + " " + token.value);
+        }
+        if (actual != expected.tokens) {
+            std::string got;
+            for (const std::string& line : actual) {
+                got += "\n    " + printable(line);
+            }
+            fail("expected tokens of %s, got:%s", printable(source).c_str(), got.c_str());
+        }
+    }
+}
+
+// The first directive token in source, or an EOF token if there is none
+static TokenSpan firstDirective(std::string_view source) {
+    Lexer lexer(source);
+    TokenSpan token = lexer.next();
+    while (token.type != TOK_EOF && !isDirective(token.type)) {
+        token = lexer.next();
+    }
+    return token;
+}
+
+// Structure pairing a source holding an #include with the header includePath must find in it
+struct ExpectedInclude {
+    const char* source;
+    bool found;
+    const char* path;
+    bool angled;
+};
+
+static void testIncludePath() {
+    const ExpectedInclude cases[] = {
+        { "#include <a/b.h>\n", true, "a/b.h", true },
+        { "#  include \"q.h\"", true, "q.h", false },
+        { "#include \"x.h\" // c\n", true, "x.h", false },
+        { "#include \\\n <c.h>\n", true, "c.h", true },
+        { "#include\t/* c */<d.h>", true, "d.h", true },
+        { "a; #include <m.h>\n", true, "m.h", true },
+        { "#include MACRO\n", false, "", false },
+        { "#include <unterminated\n", false, "", false },
+        { "#include \"unterminated\n", false, "", false },
+    };
+
+    for (const ExpectedInclude& expected : cases) {
+        std::string_view source = expected.source;
+        TokenSpan token = firstDirective(source);
+        if (token.type != TOK_PP_INCLUDE) {
+            fail("include: %s does not lex to an #include", printable(source).c_str());
+            continue;
+        }
+        std::string_view path;
+        bool angled = false;
+        bool found = includePath(token.text(source), path, angled);
+        if (found != expected.found || (found && (path != expected.path || angled != expected.angled))) {
+            fail("include: %s gives %s %s (%s), expected %s %s (%s)", printable(source).c_str(),
+                found ? "found" : "no header", printable(path).c_str(), angled ? "angled" : "quoted",
+                expected.found ? "found" : "no header", expected.path, expected.angled ? "angled" : "quoted");
+        }
+    }
+}
+
+static void testLexDirective() {
+    const ExpectedLexing cases[] = {
+        // Header names are one token with their delimiters, wherever the name sits
+        { "#include <a/b.h>\n", { "TOK_PUNCTUATION #", "TOK_IDENTIFIER include", "TOK_STRING <a/b.h>" } },
+        { "#  include \"q.h\"", { "TOK_PUNCTUATION #", "TOK_IDENTIFIER include", "TOK_STRING \"q.h\"" } },
+        { "#include \\\n <c.h>\n", { "TOK_PUNCTUATION #", "TOK_IDENTIFIER include", "TOK_STRING <c.h>" } },
+        { "#include <unterminated\n",
+            { "TOK_PUNCTUATION #", "TOK_IDENTIFIER include", "TOK_OPERATOR <", "TOK_IDENTIFIER unterminated" } },
+        // Continuations are skipped and nothing past the directive is lexed
+        { "#define A 1 \\\n + 2\nx",
+            { "TOK_PUNCTUATION #", "TOK_IDENTIFIER define", "TOK_IDENTIFIER A", "TOK_NUMBER 1", "TOK_OPERATOR +",
+                "TOK_NUMBER 2" } },
+        { "#define S \"a\\\n b\"\n",
+            { "TOK_PUNCTUATION #", "TOK_IDENTIFIER define", "TOK_IDENTIFIER S", "TOK_STRING \"a\\\n b\"" } },
+        // '#' and '##' in a body are operators, also at the end of the input
+        { "#define STR(x) #x",
+            { "TOK_PUNCTUATION #", "TOK_IDENTIFIER define", "TOK_IDENTIFIER STR", "TOK_PUNCTUATION (",
+                "TOK_IDENTIFIER x", "TOK_PUNCTUATION )", "TOK_OPERATOR #", "TOK_IDENTIFIER x" } },
+        { "#define CAT(a, b) a ## b",
+            { "TOK_PUNCTUATION #", "TOK_IDENTIFIER define", "TOK_IDENTIFIER CAT", "TOK_PUNCTUATION (",
+                "TOK_IDENTIFIER a", "TOK_PUNCTUATION ,", "TOK_IDENTIFIER b", "TOK_PUNCTUATION )",
+                "TOK_IDENTIFIER a", "TOK_OPERATOR ##", "TOK_IDENTIFIER b" } },
+        { "#if", { "TOK_PUNCTUATION #", "TOK_IDENTIFIER if" } },
+        { "#", { "TOK_PUNCTUATION #" } },
+        { "# /* c */ pragma once\n", { "TOK_PUNCTUATION #", "TOK_IDENTIFIER pragma", "TOK_IDENTIFIER once" } },
+        // A directive that does not start its line
+        { "x # define y\nz", { "TOK_PUNCTUATION #", "TOK_IDENTIFIER define", "TOK_IDENTIFIER y" } },
+    };
+
+    for (const ExpectedLexing& expected : cases) {
+        std::string_view source = expected.source;
+        TokenSpan directive = firstDirective(source);
+        std::vector<TokenSpan> spans;
+        if (isDirective(directive.type)) {
+            lexDirective(source, directive, spans);
+        }
+        std::vector<std::string> actual;
+        for (const TokenSpan& span : spans) {
+            actual.push_back(tokenTypeToString(span.type) + " " + std::string(span.text(source)));
+        }
+        if (actual != expected.tokens) {
+            std::string got;
+            for (const std::string& line : actual) {
+                got += "\n    " + printable(line);
+            }
+            fail("expected directive sub-tokens of %s, got:%s", printable(source).c_str(), got.c_str());
+        }
+    }
+}
+
+// The owning API, the span API and the pull Lexer agree token for token
+static void testApisAgree() {
+    std::vector<std::string> sources = edgeCaseSources();
+    SourceGenerator generator(13);
+    for (int round = 0; round < 200; round++) {
+        sources.push_back(generator.make(generator.between(1, 200)));
+    }
+
+    for (const std::string& source : sources) {
+        std::vector<TokenSpan> spans;
+        tokenize(std::string_view(source), spans);
+
+        std::vector<TokenSpan> pulled;
+        Lexer lexer(source);
+        for (TokenSpan token = lexer.next(); token.type != TOK_EOF; token = lexer.next()) {
+            pulled.push_back(token);
+        }
+        sameTokens("Lexer::next", source, spans, pulled);
+
+        std::vector<Token> owned = tokenize(source);
+        std::vector<TokenSpan> ownedSpans;
+        for (const Token& token : owned) {
+            CHECK(token.value == source.substr(token.offset, token.value.length()));
+            ownedSpans.push_back(TokenSpan{ token.type, token.offset, static_cast<uint32_t>(token.value.length()) });
+        }
+        sameTokens("tokenize(const std::string&)", source, spans, ownedSpans);
+
+        // Tokens tile the input: nothing but whitespace between them
+        size_t end = 0;
+        for (const TokenSpan& token : spans) {
+            CHECK(token.length > 0);
+            for (size_t i = end; i < token.offset; i++) {
+                CHECK(source[i] == ' ' || (source[i] >= '\t' && source[i] <= '\r'));
+            }
+            end = size_t(token.offset) + token.length;
+        }
+        CHECK(end <= source.length());
+    }
+}
+
+// Structure to represent one token handed to TokenDumpWriter
+struct DumpedToken {
+    TokenType type;
+    uint64_t offset;
+    std::string text;
+};
+
+// Everything a TokenDumpWriter writes for tokens, read back from a temporary file
+static std::string dump(DumpFormat format, size_t batchSize, const std::vector<DumpedToken>& tokens) {
+    std::FILE* file = std::tmpfile();
+    if (!file) {
+        fail("tmpfile() failed");
+        return std::string();
+    }
+    TokenDumpWriter writer(file, format, batchSize);
+    for (const DumpedToken& token : tokens) {
+        writer.write(token.type, token.offset, token.text);
+    }
+    writer.flush();
+    std::rewind(file);
+    std::string out;
+    char buffer[4096];
+    for (size_t got; (got = std::fread(buffer, 1, sizeof(buffer), file)) > 0;) {
+        out.append(buffer, got);
+    }
+    std::fclose(file);
+    return out;
+}
+
+static void testTokenDump() {
+    const std::vector<DumpedToken> tokens = {
+        { TOK_STRING, 0, R"("q\"b\\")" },
+        { TOK_COMMENT, 9, "// a\tb\\\r\nc" },
+        { TOK_IDENTIFIER, 21, "\xc3\xa9t\xff" },
+        { TOK_CHAR, 26, "'\x01\x1f\x7f'" },
+        { TOK_STRING, 32, std::string("\"\0\"", 3) },
+    };
+    const std::string expected[] = {
+        // DUMP_TEXT: raw bytes after the type name
+        "TOK_STRING " R"("q\"b\\")" "\n"
+        "TOK_COMMENT // a\tb\\\r\nc\n"
+        "TOK_IDENTIFIER \xc3\xa9t\xff\n"
+        "TOK_CHAR '\x01\x1f\x7f'\n"
+        + std::string("TOK_STRING \"\0\"\n", 15),
+        // DUMP_TSV: tab, newline, carriage return and backslash escaped, nothing else
+        "type\toffset\tlength\ttext\n"
+        "TOK_STRING\t0\t8\t" R"("q\\"b\\\\")" "\n"
+        "TOK_COMMENT\t9\t10\t" R"(// a\tb\\\r\nc)" "\n"
+        "TOK_IDENTIFIER\t21\t4\t\xc3\xa9t\xff\n"
+        "TOK_CHAR\t26\t5\t'\x01\x1f\x7f'\n"
+        + std::string("TOK_STRING\t32\t3\t\"\0\"\n", 20),
+        // DUMP_JSON: quote, backslash and control bytes escaped; 0x7f and up pass through
+        R"({"type":"TOK_STRING","offset":0,"length":8,"text":"\"q\\\"b\\\\\""})" "\n"
+        R"({"type":"TOK_COMMENT","offset":9,"length":10,"text":"// a\tb\\\r\nc"})" "\n"
+        R"({"type":"TOK_IDENTIFIER","offset":21,"length":4,"text":")" "\xc3\xa9t\xff" R"("})" "\n"
+        R"({"type":"TOK_CHAR","offset":26,"length":5,"text":"'\u0001\u001f)" "\x7f" R"('"})" "\n"
+        R"({"type":"TOK_STRING","offset":32,"length":3,"text":"\"\u0000\""})" "\n",
+    };
+    const DumpFormat formats[] = { DUMP_TEXT, DUMP_TSV, DUMP_JSON };
+    const char* const names[] = { "text", "tsv", "json" };
+
+    // A token many times the smallest batch goes out in pieces; the bytes must not change
+    std::string large;
+    for (int i = 0; i < 4000; i++) {
+        large += "ab\t\"\\\n\x01\xe2"[i % 8];
+    }
+    std::vector<DumpedToken> withLarge = tokens;
+    withLarge.insert(withLarge.begin() + 2, DumpedToken{ TOK_COMMENT, 12, large });
+
+    for (int f = 0; f < 3; f++) {
+        std::string actual = dump(formats[f], 1 << 20, tokens);
+        if (actual != expected[f]) {
+            fail("TokenDumpWriter %s: got %s", names[f], printable(actual, 400).c_str());
+        }
+        CHECK(dump(formats[f], 0, tokens) == expected[f]);
+        CHECK(dump(formats[f], 0, withLarge) == dump(formats[f], 1 << 20, withLarge));
+    }
+}
+
+// Escapes decode to their bytes; invalid ones stand for their letter
+static void testUnescape() {
+    const std::pair<const char*, std::string> cases[] = {
+        { R"("a\n\t\r\\\"\'\?")", "a\n\t\r\\\"'?" },
+        { R"('\0')", std::string(1, '\0') },
+        { R"("\101\1012\7")", "AA2\7" },
+        { R"("\x41\x4142\x")", "A\x42x" },
+        { R"("\u00e9\u20AC")", "\xc3\xa9\xe2\x82\xac" },
+        { R"("\U0001F600\U0010FFFF")", "\xf0\x9f\x98\x80\xf4\x8f\xbf\xbf" },
+        { R"("\uD7FF\uE000")", "\xed\x9f\xbf\xee\x80\x80" },
+        // Surrogates, short escapes and code points past U+10FFFF are invalid
+        { R"("\uD800")", "uD800" },
+        { R"("\udfff")", "udfff" },
+        { R"("\U0000DC00")", "U0000DC00" },
+        { R"("\U00110000")", "U00110000" },
+        { R"("\u12")", "u12" },
+        { R"("\q")", "q" },
+    };
+    for (const auto& expected : cases) {
+        std::string_view literal = expected.first;
+        std::string decoded(literalBody(literal).length(), '\0');
+        decoded.resize(unescapeLiteral(literal, &decoded[0]));
+        if (decoded != expected.second) {
+            fail("unescapeLiteral(%s) gave %s", printable(literal).c_str(), printable(decoded).c_str());
+        }
+    }
+}
+
+// The tokens of tokenize() come back unchanged out of a TokenStream, whether
+// it lexes the source itself, takes the spans, or has them pushed one by one
+static void testTokenStream() {
+    std::vector<std::string> sources = edgeCaseSources();
+    SourceGenerator generator(17);
+    for (int round = 0; round < 100; round++) {
+        sources.push_back(generator.make(generator.between(1, 300)));
+    }
+
+    for (const std::string& source : sources) {
+        std::vector<Token> owned = tokenize(source);
+        std::vector<TokenSpan> spans;
+        tokenize(std::string_view(source), spans);
+
+        TokenStream lexed(source);
+        TokenStream taken(source, spans);
+        TokenStream pushed;
+        pushed.assign(source, {});
+        SymbolTable table;
+        for (size_t i = 0; i < spans.size(); i++) {
+            pushed.push(spans[i]);
+            if (i == spans.size() / 2) {
+                pushed.intern(table);  // Tokens pushed after this have no symbol until the next intern()
+            }
+        }
+        pushed.intern(table);
+
+        for (const TokenStream* stream : { &lexed, &taken, &pushed }) {
+            std::vector<TokenSpan> back;
+            for (size_t i = 0; i < stream->size(); i++) {
+                back.push_back(stream->span(i));
+                CHECK(i >= owned.size() || stream->text(i) == owned[i].value);
+            }
+            sameTokens("TokenStream", source, spans, back);
+
+            std::vector<TokenSpan> iterated;
+            for (TokenRef token : *stream) {
+                iterated.push_back(TokenSpan{ token.type, token.offset, token.length });
+            }
+            sameTokens("TokenStream::iterator", source, spans, iterated);
+
+            CHECK(stream->numberCount() == lexed.numberCount());
+            for (size_t k = 0; k < stream->numberCount() && k < lexed.numberCount(); k++) {
+                CHECK(stream->numberTokens()[k] == lexed.numberTokens()[k]);
+                CHECK(stream->numbers()[k].kind == lexed.numbers()[k].kind);
+            }
+        }
+
+        // Interned identifiers map back to their text; nothing else has a symbol
+        for (size_t i = 0; i < pushed.size(); i++) {
+            SymbolId symbol = pushed.symbol(i);
+            if (pushed.type(i) == TOK_IDENTIFIER) {
+                CHECK(symbol != NO_SYMBOL && table.text(symbol) == pushed.text(i));
+                CHECK(pushed[i].symbol == symbol);
+            }
+            else {
+                CHECK(symbol == NO_SYMBOL);
+            }
+        }
+    }
+
+    // A push after intern() leaves the new token without a symbol
+    std::string source = "a b";
+    TokenStream stream(source, { TokenSpan{ TOK_IDENTIFIER, 0, 1 } });
+    SymbolTable table;
+    stream.intern(table);
+    stream.push(TokenSpan{ TOK_IDENTIFIER, 2, 1 });
+    CHECK(stream.size() == 2 && stream.symbol(0) == table.find("a") && stream.symbol(1) == NO_SYMBOL);
+    stream.intern(table);
+    CHECK(stream.symbol(1) == table.find("b") && stream.text(1) == "b");
+}
+
+// Structure pairing a source offset with the location it must map to
+struct ExpectedLocation {
+    const char* source;
+    size_t offset;
+    uint32_t line;
+    uint32_t column;
+};
+
+// Line and column by counting newlines before offset
+static SourceLocation countLocation(std::string_view source, size_t offset) {
+    size_t newline = offset == 0 ? std::string_view::npos : source.rfind('\n', offset - 1);
+    size_t lineStart = newline == std::string_view::npos ? 0 : newline + 1;
+    uint32_t line = 1;
+    for (size_t i = 0; i < offset; i++) {
+        line += source[i] == '\n';
+    }
+    return SourceLocation{ line, static_cast<uint32_t>(offset - lineStart + 1) };
+}
+
+static void testLineIndex() {
+    const ExpectedLocation cases[] = {
+        { "", 0, 1, 1 },
+        { "ab\ncd", 2, 1, 3 },       // On the newline: the last column of its line
+        { "ab\ncd", 3, 2, 1 },
+        { "ab\ncd", 5, 2, 3 },       // At EOF
+        { "ab\ncd", 99, 2, 3 },      // Past EOF
+        { "ab\n", 3, 1, 4 },         // A trailing newline does not start a line
+        { "ab\r\ncd", 2, 1, 3 },     // CRLF: the CR is in the line ...
+        { "ab\r\ncd", 3, 1, 4 },
+        { "ab\r\ncd", 4, 2, 1 },     // ... and the line after the LF
+        { "ab\rcd", 3, 1, 4 },       // A lone CR does not end a line
+        { "\n\n\nx", 3, 4, 1 },
+        { "\n\n\nx", 2, 3, 1 },
+    };
+    for (const ExpectedLocation& expected : cases) {
+        LineIndex index(expected.source);
+        SourceLocation location = index.locate(expected.offset);
+        if (location.line != expected.line || location.column != expected.column) {
+            fail("locate(%zu) in %s gave %u:%u, expected %u:%u", expected.offset, printable(expected.source).c_str(),
+                 location.line, location.column, expected.line, expected.column);
+        }
+    }
+    CHECK(LineIndex("ab\r\ncd\r\n").lineCount() == 2);
+    CHECK(LineIndex("ab\r\ncd\r\n").lineText(1) == "ab");
+    CHECK(LineIndex("ab\rcd").lineCount() == 1);
+
+    // TokenStream builds its index on the first location() and again after assign()
+    std::string first = "int a;\r\n// c\r\n\r\n  b = 1;\rc\n";
+    std::string second = "x\ny\nz";
+    TokenStream stream(first);
+    for (const std::string* source : { &first, &second }) {
+        if (source == &second) {
+            stream.assign(second);
+        }
+        for (size_t i = 0; i < stream.size(); i++) {
+            SourceLocation actual = stream.location(i);
+            SourceLocation expected = countLocation(*source, stream.offset(i));
+            if (actual.line != expected.line || actual.column != expected.column) {
+                fail("TokenStream::location(%zu) in %s gave %u:%u, expected %u:%u", i, printable(*source).c_str(),
+                     actual.line, actual.column, expected.line, expected.column);
+            }
+        }
+    }
+    CHECK(stream.location(2).line == 3 && stream.location(2).column == 1);
+}
+
+// Structure pairing a numeric literal with the value parseNumber must give it
+struct ExpectedNumber {
+    const char* text;
+    NumberKind kind;
+    uint8_t suffix;
+    bool overflow;
+    uint64_t integer;   // Compared for NUM_INTEGER
+    double floating;    // Compared for NUM_FLOATING
+};
+
+static void testParseNumber() {
+    const double inf = HUGE_VAL;
+    const ExpectedNumber cases[] = {
+        // Bases and digit separators
+        { "0", NUM_INTEGER, 0, false, 0, 0 },
+        { "42", NUM_INTEGER, 0, false, 42, 0 },
+        { "0x1F", NUM_INTEGER, 0, false, 31, 0 },
+        { "0XaBc", NUM_INTEGER, 0, false, 0xabc, 0 },
+        { "017", NUM_INTEGER, 0, false, 15, 0 },
+        { "0b1010", NUM_INTEGER, 0, false, 10, 0 },
+        { "0B1", NUM_INTEGER, 0, false, 1, 0 },
+        { "1'000'000", NUM_INTEGER, 0, false, 1000000, 0 },
+        { "0x7fff'ffff", NUM_INTEGER, 0, false, 0x7fffffff, 0 },
+        { "0b1'0", NUM_INTEGER, 0, false, 2, 0 },
+        { "0'7", NUM_INTEGER, 0, false, 7, 0 },
+        // Integer suffixes
+        { "1u", NUM_INTEGER, NUM_UNSIGNED, false, 1, 0 },
+        { "1L", NUM_INTEGER, NUM_LONG, false, 1, 0 },
+        { "1ll", NUM_INTEGER, NUM_LONG_LONG, false, 1, 0 },
+        { "1uLL", NUM_INTEGER, NUM_UNSIGNED | NUM_LONG_LONG, false, 1, 0 },
+        { "1llu", NUM_INTEGER, NUM_UNSIGNED | NUM_LONG_LONG, false, 1, 0 },
+        { "1zu", NUM_INTEGER, NUM_UNSIGNED | NUM_SIZE, false, 1, 0 },
+        { "12_km", NUM_INTEGER, NUM_USER, false, 12, 0 },
+        // Unsigned 64-bit limit and overflow
+        { "18446744073709551615", NUM_INTEGER, 0, false, UINT64_MAX, 0 },
+        { "0xffff'ffff'ffff'ffff", NUM_INTEGER, 0, false, UINT64_MAX, 0 },
+        { "18446744073709551616", NUM_INTEGER, 0, true, UINT64_MAX, 0 },
+        { "0x1'0000'0000'0000'0000u", NUM_INTEGER, NUM_UNSIGNED, true, UINT64_MAX, 0 },
+        // Fractions, exponents and floating suffixes
+        { "1.5", NUM_FLOATING, 0, false, 0, 1.5 },
+        { ".25", NUM_FLOATING, 0, false, 0, 0.25 },
+        { "2.", NUM_FLOATING, 0, false, 0, 2.0 },
+        { "1e3", NUM_FLOATING, 0, false, 0, 1000.0 },
+        { "25E-2", NUM_FLOATING, 0, false, 0, 0.25 },
+        { "1e+1'0", NUM_FLOATING, 0, false, 0, 1e10 },
+        { "0.5f", NUM_FLOATING, NUM_FLOAT, false, 0, 0.5 },
+        { "0.1f", NUM_FLOATING, NUM_FLOAT, false, 0, static_cast<double>(0.1f) },
+        { "3.0L", NUM_FLOATING, NUM_LONG, false, 0, 3.0 },
+        { "1.5_m", NUM_FLOATING, NUM_USER, false, 0, 1.5 },
+        { "1e400", NUM_FLOATING, 0, true, 0, inf },
+        { "1e-400", NUM_FLOATING, 0, true, 0, 0.0 },
+        // Hex floats take a binary exponent
+        { "0x1p4", NUM_FLOATING, 0, false, 0, 16.0 },
+        { "0x1.8p1", NUM_FLOATING, 0, false, 0, 3.0 },
+        { "0X.8P-1", NUM_FLOATING, 0, false, 0, 0.25 },
+        { "0x1p-1f", NUM_FLOATING, NUM_FLOAT, false, 0, 0.5 },
+        // Malformed literals
+        { "0x", NUM_INVALID, 0, false, 0, 0 },
+        { "0b", NUM_INVALID, 0, false, 0, 0 },
+        { "1e", NUM_INVALID, 0, false, 0, 0 },
+        { "1e+", NUM_INVALID, 0, false, 0, 0 },
+        { "0b2", NUM_INVALID, 0, false, 0, 0 },
+        { "0b12", NUM_INVALID, 0, false, 0, 0 },
+        { "08", NUM_INVALID, 0, false, 0, 0 },
+        { "09.x", NUM_INVALID, 0, false, 0, 0 },
+        { "0x1.8", NUM_INVALID, 0, false, 0, 0 },
+        { "0b1.0", NUM_INVALID, 0, false, 0, 0 },
+        { "12abc", NUM_INVALID, 0, false, 0, 0 },
+        { "1uu", NUM_INVALID, 0, false, 0, 0 },
+        { "1lL", NUM_INVALID, 0, false, 0, 0 },
+        { "1.0u", NUM_INVALID, 0, false, 0, 0 },
+        { "1''2", NUM_INVALID, 0, false, 0, 0 },
+        { "1'", NUM_INVALID, 0, false, 0, 0 },
+        { "0x'1", NUM_INVALID, 0, false, 0, 0 },
+        { "1'.5", NUM_INVALID, 0, false, 0, 0 },
+        { "1'e5", NUM_INVALID, 0, false, 0, 0 },
+        { "1'u", NUM_INVALID, 0, false, 0, 0 },
+    };
+
+    for (const ExpectedNumber& expected : cases) {
+        NumericValue value;
+        bool valid = parseNumber(expected.text, value);
+        bool same = valid == (expected.kind != NUM_INVALID) && value.kind == expected.kind;
+        if (same && expected.kind != NUM_INVALID) {
+            same = value.suffix == expected.suffix && value.overflow == expected.overflow;
+            if (expected.kind == NUM_INTEGER) {
+                same = same && value.integer == expected.integer;
+            }
+            else {
+                same = same && value.floating == expected.floating;
+            }
+        }
+        if (!same) {
+            fail("parseNumber(%s): kind %d suffix %d overflow %d integer %llu floating %g", printable(expected.text).c_str(),
+                 value.kind, value.suffix, value.overflow, static_cast<unsigned long long>(value.integer), value.floating);
+        }
+    }
+}
+
+// TokenStream::number() finds the entry of the sparse number column for a token index
+static void testStreamNumbers() {
+    std::string source = "a 1 b c 0x10 d(2.5f) 08 e";
+    TokenStream stream(source);
+    CHECK(stream.numberCount() == 4);
+    size_t found = 0;
+    for (size_t i = 0; i < stream.size(); i++) {
+        const NumericValue* value = stream.number(i);
+        if (stream.type(i) != TOK_NUMBER) {
+            CHECK(value == nullptr);
+            continue;
+        }
+        CHECK(value != nullptr);
+        if (value == nullptr) {
+            continue;
+        }
+        CHECK(found < stream.numberCount() && stream.numberTokens()[found] == i);
+        CHECK(value == stream.numbers() + found);
+        NumericValue expected;
+        parseNumber(stream.text(i), expected);
+        CHECK(value->kind == expected.kind && value->suffix == expected.suffix);
+        found++;
+    }
+    CHECK(found == 4);
+
+    // Token indices 1, 4, 7 and 9: a, 1, b, c, 0x10, d, (, 2.5f, ), 08, e
+    CHECK(stream.number(1) && stream.number(1)->integer == 1);
+    CHECK(stream.number(4) && stream.number(4)->integer == 16);
+    CHECK(stream.number(7) && stream.number(7)->floating == 2.5 && stream.number(7)->suffix == NUM_FLOAT);
+    CHECK(stream.number(9) && stream.number(9)->kind == NUM_INVALID);
+    CHECK(stream.number(0) == nullptr && stream.number(8) == nullptr && stream.number(10) == nullptr);
+}
+
+int main() {
+    testAgainstLegacy();
+    testExpectedTokens();
+    testIncludePath();
+    testLexDirective();
+    testApisAgree();
+    testTokenStream();
+    testLineIndex();
+    testUnescape();
+    testParseNumber();
+    testStreamNumbers();
+    testTokenDump();
+    std::printf("lexer_test: %d failures\n", failureCount());
+    return failureCount() ? 1 : 0;
+}
@@ -0,0 +1,158 @@
+#ifndef TESTUTIL_H
+#define TESTUTIL_H
+
+// Shared helpers for the test executables: failure counting, token list
+// comparison and generated sources. Each test is a plain executable that
+// prints what failed and exits non-zero, so ctest needs no framework.
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "tokenizer.h"
+
+// Failures seen so far; main() returns it
+inline int& failureCount() {
+    static int failures = 0;
+    return failures;
+}
+
+// Record a failure with a printf-style message
+template <typename... Args>
+void fail(const char* format, Args... args) {
+    failureCount()++;
+    std::printf("FAIL: ");
+    std::printf(format, args...);
+    std::printf("\n");
+}
+
+#define CHECK(condition) \
+    ((condition) ? (void)0 : fail("%s:%d: %s", __FILE__, __LINE__, #condition))
+
+// Printable form of a piece of source for failure messages (escapes, truncated)
+inline std::string printable(std::string_view text, size_t limit = 60) {
+    std::string out = "\"";
+    for (size_t i = 0; i < text.length() && i < limit; i++) {
+        char c = text[i];
+        if (c == '\n') {
+            out += "\\n";
+        }
+        else if (c == '\r') {
+            out += "\\r";
+        }
+        else if (c == '\t') {
+            out += "\\t";
+        }
+        else if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        }
+        else {
+            out += c;
+        }
+    }
+    out += text.length() > limit ? "\"..." : "\"";
+    return out;
+}
+
+// Compare two token lists over the same source; reports the first difference
+inline bool sameTokens(const char* what, std::string_view source,
+    const std::vector<TokenSpan>& expected, const std::vector<TokenSpan>& actual) {
+    size_t count = expected.size() < actual.size() ? expected.size() : actual.size();
+    for (size_t k = 0; k < count; k++) {
+        const TokenSpan& want = expected[k];
+        const TokenSpan& got = actual[k];
+        if (want.type != got.type || want.offset != got.offset || want.length != got.length) {
+            fail("%s: token %zu is %s %s at %u, expected %s %s at %u (source %s)", what, k,
+                tokenTypeToString(got.type).c_str(), printable(got.text(source)).c_str(), got.offset,
+                tokenTypeToString(want.type).c_str(), printable(want.text(source)).c_str(), want.offset,
+                printable(source).c_str());
+            return false;
+        }
+    }
+    if (expected.size() != actual.size()) {
+        fail("%s: %zu tokens, expected %zu (source %s)", what, actual.size(), expected.size(),
+            printable(source).c_str());
+        return false;
+    }
+    return true;
+}
+
+// Sources exercising every lexer branch, including the ones that end the input mid-token
+inline const std::vector<std::string>& edgeCaseSources() {
+    static const std::vector<std::string> sources = {
+        "",
+        "/* unterminated",
+        "/*",
+        "/*/",
+        "x /* a * / b",
+        "a /**/ b /***/ c",
+        "\"unterminated string",
+        "\"ends with backslash\\",
+        "'",
+        "'unterminated char",
+        "\"a\\\nb\" c",
+        "\"a\\\r\nb\" c",
+        "// comment \\\nnext",
+        "#define A 1 \\\n  + 2\nint x;",
+        "#define A 1 \\\r\n  + 2\r\nint x;",
+        "#if X /* spans\nlines */ && Y\n#endif",
+        "#error don't stop here\nint y;",
+        "#define S \"a\\\r\n b\" /* x\n */ c\nint z;",
+        "#include <a/b.h> // trailing\n",
+        "#",
+        "a\\\nb",
+        "x = y->z + p->*q; a <<= b >>= c <=> d;",
+        "a...b .. c .5 1.e+5f 0x1p-3 1'000'000 1'",
+        "x::y ::z :",
+        "@ $ ` \x01 \x7f \xff",
+        "int main() { return 0; }\n",
+    };
+    return sources;
+}
+
+// Generator of random C++-like source from fragments of every construct;
+// tail fragments may leave a comment, literal or directive open at the end
+class SourceGenerator {
+public:
+    explicit SourceGenerator(uint32_t seed) : random_(seed) {}
+
+    std::string make(size_t fragments) {
+        static const char* const pieces[] = {
+            "int", "while", "template", "x", "_y9", "identifier_long_enough", "0", "42", "3.14", "0x1Fu",
+            "1e+5", "1'000", ".5", "+", "-", "*", "/", "=", "<", ">", "!", "&", "|", "^", "%", "~",
+            "<<", ">>=", "==", "!=", "++", "--", "&&", "->", "->*", "...", ".", "::", ":", ";", ",",
+            "(", ")", "[", "]", "{", "}", "?", "\"str\"", "\"esc\\\"aped\\\\\"", "'c'", "'\\n'", "'\\''",
+            "// line comment\n", "/* block */", "/* multi\nline */", "#include <vector>\n",
+            "#define M(a) a \\\n + 1\n", "#if defined(X) /* c */\n", "#endif\n", "\\", "@", " ", "\n",
+            "\t", "\r\n", "  ", "a\\\nb",
+        };
+        static const char* const tails[] = {
+            "", "", "", "/* open", "\"open", "'open", "// last", "#define OPEN", "\"esc\\", "/", "-", ".", "1'",
+        };
+        std::string out;
+        std::uniform_int_distribution<size_t> pick(0, sizeof(pieces) / sizeof(pieces[0]) - 1);
+        std::uniform_int_distribution<int> space(0, 2);
+        for (size_t k = 0; k < fragments; k++) {
+            out += pieces[pick(random_)];
+            if (space(random_) == 0) {
+                out += ' ';
+            }
+        }
+        std::uniform_int_distribution<size_t> pickTail(0, sizeof(tails) / sizeof(tails[0]) - 1);
+        out += tails[pickTail(random_)];
+        return out;
+    }
+
+    // Uniform integer in [low, high]
+    size_t between(size_t low, size_t high) {
+        return std::uniform_int_distribution<size_t>(low, high)(random_);
+    }
+
+private:
+    std::mt19937 random_;
+};
+
+#endif // TESTUTIL_H
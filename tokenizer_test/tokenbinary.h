@@ -0,0 +1,91 @@
+#ifndef TOKENBINARY_H
+#define TOKENBINARY_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "tokenizer.h"
+
+// Compact binary token format (version 1), all integers LEB128 varints:
+//
+//   "TOKB" version:u8 flags:u8
+//   sourceLength tokenCount recordBytes
+//   tokenCount records of: type:u8 gap length
+//   [flags & TOKB_VALUES] valueCount, then per value: indexDelta length bytes
+//
+// gap is the distance from the end of the previous token to the start of
+// this one (usually 0 or 1), so a typical token takes three bytes. The
+// optional value table holds the unescaped contents of the string and char
+// literals that contain escapes, keyed by the distance in token indices from
+// the previous entry. Literals without escapes have no entry; their value is
+// literalBody() of their text.
+
+// Flag bits of the header
+enum TokenBinaryFlags {
+    TOKB_VALUES = 1,  // A value table follows the records
+};
+
+// Function to append the binary encoding of tokens lexed from source to out;
+// withValues adds the table of unescaped literal contents
+void writeTokens(std::string_view source, const TokenSpan* tokens, size_t count, std::string& out,
+    bool withValues = false); // Function declaration
+
+// Function to append the binary encoding of a token vector to out
+inline void writeTokens(std::string_view source, const std::vector<TokenSpan>& tokens, std::string& out,
+    bool withValues = false) {
+    writeTokens(source, tokens.data(), tokens.size(), out, withValues);
+}
+
+// Structure returned by TokenReader for each token
+struct DecodedToken {
+    TokenType type;          // Type of token
+    uint32_t offset;         // Byte offset of the token in the source
+    uint32_t length;         // Length of the token in bytes
+    bool hasValue;           // Whether value comes from the value table
+    std::string_view value;  // Unescaped literal contents, pointing into the encoded buffer
+};
+
+// Sequential decoder over an encoded buffer. Nothing is copied: value views
+// point into the buffer, which must outlive the reader. Malformed input
+// throws std::runtime_error.
+class TokenReader {
+public:
+    explicit TokenReader(std::string_view data);
+
+    size_t size() const { return count_; }
+    size_t sourceLength() const { return sourceLength_; }
+    bool hasValues() const { return (flags_ & TOKB_VALUES) != 0; }
+
+    // Decode the next token; returns false after the last one
+    bool next(DecodedToken& token);
+
+    // Start again from the first token
+    void rewind();
+
+    // Decode everything into spans (values are dropped)
+    void readAll(std::vector<TokenSpan>& out);
+
+private:
+    uint64_t readVarint(size_t& cursor, size_t limit) const;
+    void loadNextValue();
+
+    std::string_view data_;
+    uint8_t flags_ = 0;
+    size_t sourceLength_ = 0;
+    size_t count_ = 0;
+    size_t recordsBegin_ = 0;
+    size_t recordsEnd_ = 0;
+    size_t valuesBegin_ = 0;
+
+    // Decoding position
+    size_t cursor_ = 0;
+    size_t index_ = 0;
+    uint64_t end_ = 0;             // End offset of the previous token
+    size_t valueCursor_ = 0;
+    size_t valuesLeft_ = 0;
+    size_t nextValueIndex_ = 0;    // Token index of the pending value entry
+    std::string_view nextValue_;
+};
+
+#endif // TOKENBINARY_H
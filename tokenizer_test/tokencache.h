@@ -0,0 +1,79 @@
+#ifndef TOKENCACHE_H
+#define TOKENCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "mappedfile.h"
+#include "tokenizer.h"
+
+// Function to hash bytes with a fast non-cryptographic 64-bit hash
+uint64_t hashBytes(const void* data, size_t length, uint64_t seed = 0); // Function declaration
+
+// Structure holding the tokens returned by TokenCache. On a hit they are read
+// straight out of the mapped cache entry; on a miss they are freshly lexed.
+struct CachedTokens {
+    MappedFile entry;               // The cache entry, when hit
+    std::vector<TokenSpan> lexed;   // The tokens, when missed
+    const TokenSpan* tokens = nullptr;
+    size_t count = 0;
+    bool hit = false;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const TokenSpan& operator[](size_t i) const { return tokens[i]; }
+    const TokenSpan* begin() const { return tokens; }
+    const TokenSpan* end() const { return tokens + count; }
+};
+
+// Structure holding a mapped source file together with its cached tokens
+struct CachedFile {
+    MappedFile file;
+    CachedTokens tokens;
+
+    std::string_view source() const { return file.view(); }
+};
+
+// Persistent token cache in a directory. Entries are named after a hash of
+// the source bytes and hold a small header followed by the TokenSpan array
+// exactly as it sits in memory, so a hit costs one hash of the source, one
+// mmap of the entry and one pass checking the records, with nothing decoded.
+// An entry is ignored (and rewritten) when its format version, LEXER_VERSION,
+// byte order, source hash or source length differ from what is being looked
+// up, or when its size or any record is inconsistent with the source (a
+// truncated or damaged file is a miss, never out-of-range spans). Entries are
+// written to a temporary file and renamed into place, so concurrent processes
+// sharing the directory never see a partial entry. Failing to write an entry
+// is not an error; the tokens are still returned.
+class TokenCache {
+public:
+    // Structure counting what the cache did
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t writeFailures = 0;
+    };
+
+    // Uses directory for entries, creating it if needed
+    explicit TokenCache(std::string directory);
+
+    // Return the tokens of source, from the cache when possible
+    CachedTokens tokenize(std::string_view source);
+
+    // Map path and return it with its tokens, from the cache when possible
+    CachedFile tokenizeFile(const std::string& path);
+
+    const Stats& stats() const { return stats_; }
+    const std::string& directory() const { return directory_; }
+
+private:
+    std::string entryPath(uint64_t hash) const;
+    bool load(const std::string& path, uint64_t hash, size_t length, CachedTokens& out) const;
+    void store(const std::string& path, uint64_t hash, size_t length, const std::vector<TokenSpan>& tokens);
+
+    std::string directory_;
+    Stats stats_;
+};
+
+#endif // TOKENCACHE_H
@@ -0,0 +1,54 @@
+#ifndef TOKENDUMP_H
+#define TOKENDUMP_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <vector>
+#include "tokenizer.h"
+
+// Enum to represent the listing formats of TokenDumpWriter
+enum DumpFormat {
+    DUMP_TEXT = 0,  // "TOK_INT int", the raw token text after the type name
+    DUMP_TSV = 1,   // type, offset, length, text; a header row, and \t \n \r \\ escaped in the text
+    DUMP_JSON = 2,  // JSON Lines: {"type":...,"offset":...,"length":...,"text":...} per token
+};
+
+// Function to parse a format name ("text", "tsv" or "json"); returns false for anything else
+bool parseDumpFormat(std::string_view name, DumpFormat& format); // Function declaration
+
+// Buffered token listing. Lines are formatted straight into one large buffer
+// and handed to the stream a batch at a time, so the cost per token is one
+// capacity check and a few copies instead of a formatted, flushed stream
+// write. JSON Lines (rather than one array) keeps the output streamable: each
+// token is complete the moment its line is written, and listings of several
+// files concatenate.
+class TokenDumpWriter {
+public:
+    // Write to out (not owned) in the given format, flushing every batchSize
+    // bytes (at least 512)
+    explicit TokenDumpWriter(std::FILE* out, DumpFormat format = DUMP_TEXT, size_t batchSize = 1 << 20);
+
+    // Add one token; offset is its byte position in the source or stream
+    void write(TokenType type, uint64_t offset, std::string_view text);
+
+    // Add every token of a lexed source
+    void write(std::string_view source, const std::vector<TokenSpan>& tokens);
+
+    // Hand the buffered lines to the stream and flush it. Throws
+    // std::system_error if the stream fails. Call before destruction;
+    // the destructor drops whatever is still buffered.
+    void flush();
+
+private:
+    // Make room for n more bytes (at most batchSize_), writing out the batch first if it is full
+    char* reserve(size_t n);
+
+    std::FILE* out_;
+    DumpFormat format_;
+    size_t batchSize_;
+    std::vector<char> buffer_;  // Formatted lines; one batch, whatever the token sizes
+    size_t used_ = 0;           // Bytes of buffer_ waiting to be written
+};
+
+#endif // TOKENDUMP_H
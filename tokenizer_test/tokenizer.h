@@ -3,10 +3,12 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cstdint>
 
 // Enum to represent different types of tokens
 enum TokenType {
-    TOK_HEADER = 0,       // For preprocessor directives
+    TOK_HEADER = 0,       // For the null directive and unknown directive names
     TOK_COMMENT = 1,      // For comments
     TOK_INT = 2,          // For int keyword
     TOK_FLOAT = 3,        // For float keyword
@@ -70,32 +72,208 @@ enum TokenType {
     TOK_OVERRIDE=63,
     // New token types
     TOK_SCOPE = 64,   // For scope resolution operator (::)
+    TOK_EOF = 65,     // End of input (zero-length, returned by Lexer::next)
+
+    // Preprocessor directives: one token per logical line, from '#' up to the
+    // newline that ends it (see directive.h for taking one apart).
+    // TOK_HEADER remains for the null directive and unknown directive names.
+    TOK_PP_INCLUDE = 66,  // #include, #include_next, #import
+    TOK_PP_DEFINE = 67,
+    TOK_PP_UNDEF = 68,
+    TOK_PP_IF = 69,
+    TOK_PP_IFDEF = 70,
+    TOK_PP_IFNDEF = 71,
+    TOK_PP_ELIF = 72,     // #elif, #elifdef, #elifndef
+    TOK_PP_ELSE = 73,
+    TOK_PP_ENDIF = 74,
+    TOK_PP_PRAGMA = 75,
+    TOK_PP_ERROR = 76,
+    TOK_PP_WARNING = 77,
+    TOK_PP_LINE = 78,
 };
 
+// Function to check whether a token is a preprocessor directive
+inline bool isDirective(TokenType type) {
+    return type == TOK_HEADER || (type >= TOK_PP_INCLUDE && type <= TOK_PP_LINE);
+}
+
 // Structure to represent a token
 struct Token {
     TokenType type;      // Type of token
     std::string value;   // The actual string value of the token
+    uint32_t offset;     // Byte offset of the token in the source (see LineIndex for line/column)
+
+    Token(TokenType t, std::string val, uint32_t off = 0); // Constructor declaration
+};
+
+// Structure to represent a token as a span into a caller-owned source buffer.
+// Spans never own text, so the source must outlive them.
+struct TokenSpan {
+    TokenType type;      // Type of token
+    uint32_t offset;     // Byte offset of the token in the source
+    uint32_t length;     // Length of the token in bytes
 
-    Token(TokenType t, const std::string& val); // Constructor declaration
+    // Returns the token text inside the source it was lexed from
+    std::string_view text(std::string_view source) const { return source.substr(offset, length); }
 };
 
+// Neither Token nor TokenSpan carries the value of a TOK_NUMBER. Call
+// parseNumber() on its text, or lex into a TokenStream (tokenstream.h),
+// the only token container that stores values parsed during lexing.
+
 // Function to tokenize the input string
 std::vector<Token> tokenize(const std::string& input); // Function declaration
 
+// Function to tokenize the input into spans, appending to tokens without copying any text
+void tokenize(std::string_view input, std::vector<TokenSpan>& tokens); // Function declaration
+
+// Function to get the contents of a string or char literal token without its quotes
+std::string_view literalBody(std::string_view literal); // Function declaration
+
+// Function to decode the escape sequences of a string or char literal token into out,
+// which must hold literalBody(literal).length() bytes; returns the decoded length.
+// An invalid escape (\x without digits, a short \u, a surrogate or a code point
+// past U+10FFFF) stands for its letter, as an unknown escape does.
+size_t unescapeLiteral(std::string_view literal, char* out); // Function declaration
+
+// Enum to represent what a TOK_NUMBER token turned out to be
+enum NumberKind : uint8_t {
+    NUM_INVALID = 0,   // Not a valid literal ("09", "0x", "1e", "0b12", "12abc", "1''2")
+    NUM_INTEGER = 1,   // Value in NumericValue::integer
+    NUM_FLOATING = 2,  // Value in NumericValue::floating
+};
+
+// Suffix bits of a numeric literal
+enum NumberSuffix : uint8_t {
+    NUM_UNSIGNED = 1,   // u, U
+    NUM_LONG = 2,       // l, L (integer or floating)
+    NUM_LONG_LONG = 4,  // ll, LL
+    NUM_SIZE = 8,       // z, Z
+    NUM_FLOAT = 16,     // f, F
+    NUM_USER = 32,      // A user-defined suffix such as _km; the value is that of the literal before it
+};
+
+// Structure to represent the value of a numeric literal
+struct NumericValue {
+    NumberKind kind;    // Which member of the union holds the value
+    uint8_t suffix;     // NumberSuffix bits
+    bool overflow;      // Integer wider than 64 bits (integer is UINT64_MAX), or floating value rounded to infinity or zero
+    union {
+        uint64_t integer;
+        double floating;  // f-suffixed literals are rounded to float first
+    };
+};
+
+// Function to compute the value of a TOK_NUMBER token: any base, digit separators
+// and suffixes. Returns false and sets kind to NUM_INVALID for malformed text.
+// TokenStream::number() holds the same result for the numbers it has lexed.
+bool parseNumber(std::string_view text, NumericValue& value); // Function declaration
+
+// Function to get the name of a TokenType ("TOK_INT", ...) without allocating;
+// the view refers to a string literal, so it never dangles
+constexpr std::string_view tokenTypeName(TokenType type) {
+    switch (type) {
+    case TOK_HEADER: return "TOK_HEADER";
+    case TOK_COMMENT: return "TOK_COMMENT";
+    case TOK_INT: return "TOK_INT";
+    case TOK_FLOAT: return "TOK_FLOAT";
+    case TOK_DOUBLE: return "TOK_DOUBLE";
+    case TOK_BOOL: return "TOK_BOOL";
+    case TOK_RETURN: return "TOK_RETURN";
+    case TOK_IDENTIFIER: return "TOK_IDENTIFIER";
+    case TOK_NUMBER: return "TOK_NUMBER";
+    case TOK_OPERATOR: return "TOK_OPERATOR";
+    case TOK_PUNCTUATION: return "TOK_PUNCTUATION";
+    case TOK_STRING: return "TOK_STRING";
+    case TOK_CHAR: return "TOK_CHAR";
+    case TOK_VOID: return "TOK_VOID";
+    case TOK_NAMESPACE: return "TOK_NAMESPACE";
+    case TOK_ENUM: return "TOK_ENUM";
+    case TOK_TEMPLATE: return "TOK_TEMPLATE";
+    case TOK_KEYWORD: return "TOK_KEYWORD";
+    case TOK_UNKNOWN: return "TOK_UNKNOWN";
+
+        // Add cases for all keyword token types
+    case TOK_IF: return "TOK_IF";
+    case TOK_ELSE: return "TOK_ELSE";
+    case TOK_FOR: return "TOK_FOR";
+    case TOK_WHILE: return "TOK_WHILE";
+    case TOK_DO: return "TOK_DO";
+    case TOK_SWITCH: return "TOK_SWITCH";
+    case TOK_CASE: return "TOK_CASE";
+    case TOK_BREAK: return "TOK_BREAK";
+    case TOK_CONTINUE: return "TOK_CONTINUE";
+    case TOK_DEFAULT: return "TOK_DEFAULT";
+    case TOK_STATIC: return "TOK_STATIC";
+    case TOK_CONST: return "TOK_CONST";
+    case TOK_CLASS: return "TOK_CLASS";
+    case TOK_STRUCT: return "TOK_STRUCT";
+    case TOK_PUBLIC: return "TOK_PUBLIC";
+    case TOK_PRIVATE: return "TOK_PRIVATE";
+    case TOK_PROTECTED: return "TOK_PROTECTED";
+    case TOK_VIRTUAL: return "TOK_VIRTUAL";
+    case TOK_OVERRIDE: return "TOK_OVERRIDE";
+    case TOK_NEW: return "TOK_NEW";
+    case TOK_DELETE: return "TOK_DELETE";
+    case TOK_TRY: return "TOK_TRY";
+    case TOK_CATCH: return "TOK_CATCH";
+    case TOK_THROW: return "TOK_THROW";
+    case TOK_USING: return "TOK_USING";
+    case TOK_ASM: return "TOK_ASM";
+    case TOK_AUTO: return "TOK_AUTO";
+    case TOK_EXTERN: return "TOK_EXTERN";
+    case TOK_FRIEND: return "TOK_FRIEND";
+    case TOK_INLINE: return "TOK_INLINE";
+    case TOK_LONG: return "TOK_LONG";
+    case TOK_REGISTER: return "TOK_REGISTER";
+    case TOK_SIGNED: return "TOK_SIGNED";
+    case TOK_SHORT: return "TOK_SHORT";
+    case TOK_THIS: return "TOK_THIS";
+    case TOK_TYPEDEF: return "TOK_TYPEDEF";
+    case TOK_UNION: return "TOK_UNION";
+    case TOK_UNSIGNED: return "TOK_UNSIGNED";
+    case TOK_VOLATILE: return "TOK_VOLATILE";
+    case TOK_SCOPE: return "TOK_SCOPE";
+    case TOK_EOF: return "TOK_EOF";
+    case TOK_PP_INCLUDE: return "TOK_PP_INCLUDE";
+    case TOK_PP_DEFINE: return "TOK_PP_DEFINE";
+    case TOK_PP_UNDEF: return "TOK_PP_UNDEF";
+    case TOK_PP_IF: return "TOK_PP_IF";
+    case TOK_PP_IFDEF: return "TOK_PP_IFDEF";
+    case TOK_PP_IFNDEF: return "TOK_PP_IFNDEF";
+    case TOK_PP_ELIF: return "TOK_PP_ELIF";
+    case TOK_PP_ELSE: return "TOK_PP_ELSE";
+    case TOK_PP_ENDIF: return "TOK_PP_ENDIF";
+    case TOK_PP_PRAGMA: return "TOK_PP_PRAGMA";
+    case TOK_PP_ERROR: return "TOK_PP_ERROR";
+    case TOK_PP_WARNING: return "TOK_PP_WARNING";
+    case TOK_PP_LINE: return "TOK_PP_LINE";
+    default: return "UNKNOWN";
+    }
+}
+
+// Function to check whether a stored type value names a TokenType a token can
+// have: the enum has gaps (24, 31, 33, 42), and TOK_EOF is never a token
+constexpr bool isTokenType(uint32_t value) {
+    return value <= TOK_PP_LINE && value != TOK_EOF && tokenTypeName(static_cast<TokenType>(value)) != "UNKNOWN";
+}
+
 // Function to convert TokenType to string representation
 std::string tokenTypeToString(TokenType type); // Function declaration
 
+// Function to classify a word as its keyword TokenType, or TOK_IDENTIFIER if it is not a keyword
+TokenType classifyWord(std::string_view word); // Function declaration
+
 // Function to check if a string is a keyword
-bool isKeyword(const std::string& str); // Function declaration
+bool isKeyword(std::string_view str); // Function declaration
 
 // Function to check if a character is a valid operator
 bool isOperator(char c); // Function declaration
 
 // Function to map a word to its corresponding TokenType
-TokenType wordToTokenType(const std::string& word); // Function declaration
+TokenType wordToTokenType(std::string_view word); // Function declaration
 
-// Function to check if a string is a multi-character operator (e.g., "::", "++", "--")
-bool isMultiCharOperator(const std::string& str); // Function declaration
+// Function to check if input[i] starts a multi-character operator or punctuator (e.g., "++", "<<=", "...")
+bool isMultiCharOperator(std::string_view input, size_t i); // Function declaration
 
 #endif // TOKENIZER_H
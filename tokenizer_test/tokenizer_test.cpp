@@ -1,8 +1,318 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
+#include <string>
+#include <system_error>
 #include <vector>
-#include "Tokenizer.h"
+#include "tokenizer.h"
+#include "batch.h"
+#include "dependencyscan.h"
+#include "directive.h"
+#include "lexer.h"
+#include "lexerstats.h"
+#include "lineindex.h"
+#include "mappedfile.h"
+#include "streamlexer.h"
+#include "tokenbinary.h"
+#include "tokendump.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+// Lex standard input in 64 KiB pieces, listing tokens as they become final.
+// Each piece is flushed, so a pipe sees its tokens without waiting for a full batch.
+static void streamStdin(TokenDumpWriter& writer) {
+    std::vector<char> chunk(64 * 1024);
+    std::vector<StreamToken> tokens;
+    StreamLexer lexer;
+
+    auto print = [&]() {
+        for (const StreamToken& token : tokens) {
+            writer.write(token.type, token.offset, token.text);
+        }
+        tokens.clear();
+        writer.flush();
+    };
+
+    while (std::cin.read(chunk.data(), chunk.size()) || std::cin.gcount() > 0) {
+        lexer.feed(std::string_view(chunk.data(), static_cast<size_t>(std::cin.gcount())), tokens);
+        print();
+    }
+    lexer.finish(tokens);
+    print();
+}
+
+// Tokenize many files on the thread pool and print one summary line per file:
+//   tokenizer_test --batch [-jN] file...
+static int runBatch(int argc, char** argv) {
+    unsigned threads = 0;
+    std::vector<std::string> paths;
+    for (int arg = 2; arg < argc; arg++) {
+        std::string_view option(argv[arg]);
+        if (option.substr(0, 2) == "-j" && option.length() > 2) {
+            threads = static_cast<unsigned>(std::strtoul(argv[arg] + 2, nullptr, 10));
+        }
+        else {
+            paths.emplace_back(option);
+        }
+    }
+
+    BatchResult batch = tokenizeBatch(paths, threads);
+
+    size_t bytes = 0;
+    size_t tokens = 0;
+    for (const FileResult& result : batch.files) {
+        if (!result.error.empty()) {
+            std::cerr << "tokenizer_test: " << result.error << "\n";
+            continue;
+        }
+        bytes += result.file.file.size();
+        tokens += result.file.tokens.size();
+        std::cout << result.path << "\t" << result.file.tokens.size() << " tokens\t"
+            << result.file.file.size() << " bytes\t" << result.seconds * 1e3 << " ms\n";
+    }
+    for (size_t w = 0; w < batch.workers.size(); w++) {
+        const WorkerStats& stats = batch.workers[w];
+        std::cout << "worker " << w << ": " << stats.files << " files, " << stats.bytes << " bytes, "
+            << stats.steals << " stolen, " << stats.busySeconds * 1e3 << " ms busy\n";
+    }
+    std::cout << batch.files.size() << " files (" << batch.failed << " failed), " << tokens << " tokens, "
+        << bytes << " bytes in " << batch.wallSeconds * 1e3 << " ms ("
+        << (batch.wallSeconds > 0 ? bytes / batch.wallSeconds / 1e6 : 0) << " MB/s)" << std::endl;
+    return batch.failed ? 1 : 0;
+}
+
+// Source file extensions picked up when --deps walks a directory
+static bool isSourceFile(const std::filesystem::path& path) {
+    static const char* const extensions[] = {
+        ".c", ".cc", ".cpp", ".cxx", ".c++", ".h", ".hh", ".hpp", ".hxx", ".h++", ".inl", ".ipp", ".m", ".mm",
+    };
+    std::string extension = path.extension().string();
+    for (const char* candidate : extensions) {
+        if (extension == candidate) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Print the includes of many files and the conditionals around them, one per line as
+//   path:line: #include <header>
+// with two spaces of indentation per enclosing conditional:
+//   tokenizer_test --deps [-jN] file-or-directory...
+static int runDeps(int argc, char** argv) {
+    unsigned threads = 0;
+    std::vector<std::string> paths;
+    for (int arg = 2; arg < argc; arg++) {
+        std::string_view option(argv[arg]);
+        if (option.substr(0, 2) == "-j" && option.length() > 2) {
+            threads = static_cast<unsigned>(std::strtoul(argv[arg] + 2, nullptr, 10));
+            continue;
+        }
+        std::error_code ec;
+        if (!std::filesystem::is_directory(argv[arg], ec)) {
+            paths.emplace_back(option);
+            continue;
+        }
+        for (auto it = std::filesystem::recursive_directory_iterator(argv[arg], ec);
+            !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_regular_file(ec) && isSourceFile(it->path())) {
+                paths.push_back(it->path().string());
+            }
+        }
+        if (ec) {
+            std::cerr << "tokenizer_test: " << argv[arg] << ": " << ec.message() << "\n";
+        }
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<FileDependencies> results = scanDependencyFiles(paths, threads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    size_t bytes = 0;
+    size_t includes = 0;
+    size_t failed = 0;
+    std::string out;
+    for (const FileDependencies& result : results) {
+        if (!result.error.empty()) {
+            std::cerr << "tokenizer_test: " << result.error << "\n";
+            failed++;
+            continue;
+        }
+        bytes += result.file.size();
+        LineIndex lines(result.file.view());
+        for (const Dependency& dependency : result.dependencies) {
+            out += result.path;
+            out += ':';
+            out += std::to_string(lines.locate(dependency.offset).line);
+            out += ": ";
+            out.append(2 * dependency.depth, ' ');
+            if (dependency.type == TOK_PP_INCLUDE) {
+                includes++;
+                if (dependency.text.empty()) {
+                    out += "#include (computed)";
+                }
+                else {
+                    out += dependency.angled ? "#include <" : "#include \"";
+                    out += dependency.text;
+                    out += dependency.angled ? '>' : '"';
+                }
+            }
+            else {
+                std::string_view text = result.file.view().substr(dependency.offset, dependency.length);
+                out += '#';
+                out += directiveName(text);
+                if (!dependency.text.empty()) {
+                    out += ' ';
+                    out += dependency.text;
+                }
+            }
+            out += '\n';
+        }
+        std::cout << out;
+        out.clear();
+    }
+
+    std::cerr << results.size() << " files (" << failed << " failed), " << includes << " includes, "
+        << bytes << " bytes in " << seconds * 1e3 << " ms ("
+        << (seconds > 0 ? bytes / seconds / 1e6 : 0) << " MB/s)" << std::endl;
+    return failed ? 1 : 0;
+}
+
+// Write the binary token stream of one file to standard output:
+//   tokenizer_test --binary [--values] file
+static int writeBinary(int argc, char** argv) {
+    bool withValues = argc > 2 && std::string_view(argv[2]) == "--values";
+    int arg = withValues ? 3 : 2;
+    if (arg + 1 != argc) {
+        std::cerr << "usage: tokenizer_test --binary [--values] file" << std::endl;
+        return 1;
+    }
+
+    std::string out;
+    try {
+        TokenizedFile file = tokenizeFile(argv[arg]);
+        writeTokens(file.source(), file.tokens, out, withValues);
+    }
+    catch (const std::exception& error) {
+        std::cerr << "tokenizer_test: " << error.what() << std::endl;
+        return 1;
+    }
+
+#ifdef _WIN32
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    std::cout.write(out.data(), out.size());
+    return std::cout.flush() ? 0 : 1;
+}
+
+// Lex files with the instrumented lexer and print a JSON report of where the
+// time went: mapping versus lexing, then per-type and per-branch counts:
+//   tokenizer_test --stats file...
+static int printStats(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: tokenizer_test --stats file..." << std::endl;
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    LexerStats stats;
+    Clock::duration mapTime{};
+    Clock::duration lexTime{};
+    size_t bytes = 0;
+    int files = 0;
+    int status = 0;
+    for (int arg = 2; arg < argc; arg++) {
+        try {
+            auto mapBegin = Clock::now();
+            MappedFile file(argv[arg]);
+            auto lexBegin = Clock::now();
+            BasicLexer<StatsPolicy> lexer(file.view());
+            while (lexer.next().type != TOK_EOF) {
+            }
+            auto lexEnd = Clock::now();
+
+            mapTime += lexBegin - mapBegin;
+            lexTime += lexEnd - lexBegin;
+            stats.merge(lexer.stats());
+            bytes += file.size();
+            files++;
+        }
+        catch (const std::exception& error) {
+            std::cerr << "tokenizer_test: " << error.what() << std::endl;
+            status = 1;
+        }
+    }
+
+    double mapMs = std::chrono::duration<double, std::milli>(mapTime).count();
+    double lexMs = std::chrono::duration<double, std::milli>(lexTime).count();
+    std::cout << "{\n  \"files\": " << files << ",\n  \"bytes\": " << bytes
+        << ",\n  \"phases_ms\": {\"map\": " << mapMs << ", \"lex\": " << lexMs << "}"
+        << ",\n  \"lex_mb_per_s\": " << (lexMs > 0 ? bytes / lexMs / 1e3 : 0)
+        << ",\n  \"lexer\": " << lexerStatsJson(stats, 2) << "\n}\n";
+    return status;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string_view(argv[1]) == "--batch") {
+        return runBatch(argc, argv);
+    }
+    if (argc > 1 && std::string_view(argv[1]) == "--deps") {
+        return runDeps(argc, argv);
+    }
+    if (argc > 1 && std::string_view(argv[1]) == "--binary") {
+        return writeBinary(argc, argv);
+    }
+    if (argc > 1 && std::string_view(argv[1]) == "--stats") {
+        return printStats(argc, argv);
+    }
+
+    // Tokenize the files named on the command line straight from their mappings ("-" streams stdin):
+    //   tokenizer_test [--format=text|tsv|json] file...
+    if (argc > 1) {
+        DumpFormat format = DUMP_TEXT;
+        int arg = 1;
+        std::string_view option(argv[arg]);
+        if (option.substr(0, 9) == "--format=") {
+            if (!parseDumpFormat(option.substr(9), format)) {
+                std::cerr << "usage: tokenizer_test [--format=text|tsv|json] file..." << std::endl;
+                return 1;
+            }
+            arg++;
+        }
+
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        TokenDumpWriter writer(stdout, format);
+        int status = 0;
+        for (; arg < argc; arg++) {
+            try {
+                if (std::string_view(argv[arg]) == "-") {
+                    streamStdin(writer);
+                    continue;
+                }
+                TokenizedFile file = tokenizeFile(argv[arg]);
+                writer.write(file.source(), file.tokens);
+            }
+            catch (const std::exception& error) {
+                std::cerr << "tokenizer_test: " << error.what() << std::endl;
+                status = 1;
+            }
+        }
+        try {
+            writer.flush();
+        }
+        catch (const std::exception& error) {
+            std::cerr << "tokenizer_test: " << error.what() << std::endl;
+            status = 1;
+        }
+        return status;
+    }
 
-int main() {
     std::string input = R"(int x = 5;
 x++;
 --x;
@@ -13,8 +323,7 @@ int y = x ** 2;
 
     // Print the tokens
     for (const Token& token : tokens) {
-        if (tokenTypeToString(token.type) == "TOK_KEYWORD");
-        std::cout << tokenTypeToString(token.type) <<" " << token.value << std::endl;
+        std::cout << tokenTypeName(token.type) << " " << token.value << "\n";
     }
 
     return 0;
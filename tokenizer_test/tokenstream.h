@@ -0,0 +1,144 @@
+#ifndef TOKENSTREAM_H
+#define TOKENSTREAM_H
+
+#include <cstddef>
+#include <iterator>
+#include "lineindex.h"
+#include "symboltable.h"
+#include "tokenizer.h"
+
+// Structure returned when reading one token out of a TokenStream
+struct TokenRef {
+    TokenType type;         // Type of token
+    uint32_t offset;        // Byte offset of the token in the source
+    uint32_t length;        // Length of the token in bytes
+    std::string_view text;  // The token text inside the source
+    SymbolId symbol;        // Interned id for identifiers after intern(), NO_SYMBOL otherwise
+};
+
+// Structure-of-arrays token container. Kinds, offsets, lengths and symbols
+// each live in their own contiguous array, so a pass that only switches on
+// kinds touches one byte per token. Lines and columns are not stored; they
+// come from a LineIndex built the first time a location is asked for.
+// Numeric literals are parsed as they are lexed; their values form a sparse
+// column holding one entry per TOK_NUMBER token.
+class TokenStream {
+public:
+    // Random-access iterator yielding TokenRef values
+    class iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = TokenRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = TokenRef;
+
+        iterator() = default;
+        iterator(const TokenStream* stream, size_t index) : stream_(stream), index_(index) {}
+
+        TokenRef operator*() const { return (*stream_)[index_]; }
+        TokenRef operator[](difference_type n) const { return (*stream_)[index_ + n]; }
+        size_t index() const { return index_; }
+
+        iterator& operator++() { ++index_; return *this; }
+        iterator operator++(int) { iterator old = *this; ++index_; return old; }
+        iterator& operator--() { --index_; return *this; }
+        iterator operator--(int) { iterator old = *this; --index_; return old; }
+        iterator& operator+=(difference_type n) { index_ += n; return *this; }
+        iterator& operator-=(difference_type n) { index_ -= n; return *this; }
+        friend iterator operator+(iterator it, difference_type n) { return it += n; }
+        friend iterator operator+(difference_type n, iterator it) { return it += n; }
+        friend iterator operator-(iterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(const iterator& a, const iterator& b) {
+            return static_cast<difference_type>(a.index_) - static_cast<difference_type>(b.index_);
+        }
+
+        friend bool operator==(const iterator& a, const iterator& b) { return a.index_ == b.index_; }
+        friend bool operator!=(const iterator& a, const iterator& b) { return a.index_ != b.index_; }
+        friend bool operator<(const iterator& a, const iterator& b) { return a.index_ < b.index_; }
+        friend bool operator>(const iterator& a, const iterator& b) { return a.index_ > b.index_; }
+        friend bool operator<=(const iterator& a, const iterator& b) { return a.index_ <= b.index_; }
+        friend bool operator>=(const iterator& a, const iterator& b) { return a.index_ >= b.index_; }
+
+    private:
+        const TokenStream* stream_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    TokenStream() = default;
+
+    // Lexes source; the source buffer must outlive the stream
+    explicit TokenStream(std::string_view source);
+
+    // Takes tokens already lexed from source, e.g. by tokenize() or the token cache
+    TokenStream(std::string_view source, const std::vector<TokenSpan>& tokens);
+
+    // Replaces the contents with the tokens of a new source buffer
+    void assign(std::string_view source);
+    void assign(std::string_view source, const std::vector<TokenSpan>& tokens);
+
+    // Appends one token of source(); tokens must come in source order. Tokens
+    // pushed after intern() have no symbol until intern() is called again.
+    void push(const TokenSpan& token);
+
+    // Removes all tokens, keeping the allocated capacity
+    void clear();
+
+    // Interns every identifier into table and fills the symbol column
+    void intern(SymbolTable& table);
+
+    size_t size() const { return kinds_.size(); }
+    bool empty() const { return kinds_.empty(); }
+    std::string_view source() const { return source_; }
+
+    TokenRef operator[](size_t i) const {
+        return TokenRef{ type(i), offsets_[i], lengths_[i], text(i), symbol(i) };
+    }
+
+    // Per-field accessors that only touch the array they need
+    TokenType type(size_t i) const { return static_cast<TokenType>(kinds_[i]); }
+    uint32_t offset(size_t i) const { return offsets_[i]; }
+    uint32_t length(size_t i) const { return lengths_[i]; }
+    std::string_view text(size_t i) const { return source_.substr(offsets_[i], lengths_[i]); }
+    TokenSpan span(size_t i) const { return TokenSpan{ type(i), offsets_[i], lengths_[i] }; }
+    SymbolId symbol(size_t i) const { return symbols_.empty() ? NO_SYMBOL : symbols_[i]; }
+
+    // Value of a TOK_NUMBER token (kind NUM_INVALID if malformed); nullptr for other tokens
+    const NumericValue* number(size_t i) const;
+
+    // Line and column of a token's first byte; the first call indexes the source
+    SourceLocation location(size_t i) const { return lines_.locate(offsets_[i]); }
+    const LineIndex& lineIndex() const { return lines_; }
+
+    // Raw column arrays for passes that want to scan them directly
+    const uint8_t* kinds() const { return kinds_.data(); }
+    const uint32_t* offsets() const { return offsets_.data(); }
+    const uint32_t* lengths() const { return lengths_.data(); }
+    const SymbolId* symbols() const { return symbols_.data(); } // Empty until intern()
+
+    // Sparse number column: numberCount() values, and for each the index of its token
+    size_t numberCount() const { return numbers_.size(); }
+    const NumericValue* numbers() const { return numbers_.data(); }
+    const uint32_t* numberTokens() const { return numberTokens_.data(); }
+
+    // Returns the index of the first token of the given kind at or after from, or size()
+    size_t find(TokenType kind, size_t from = 0) const;
+
+    // Returns how many tokens have the given kind
+    size_t count(TokenType kind) const;
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, size()); }
+
+private:
+    std::string_view source_;
+    std::vector<uint8_t> kinds_;
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> lengths_;
+    LineIndex lines_;
+    std::vector<SymbolId> symbols_;
+    std::vector<NumericValue> numbers_;
+    std::vector<uint32_t> numberTokens_;  // Ascending token indices of numbers_
+};
+
+#endif // TOKENSTREAM_H